@@ -0,0 +1,140 @@
+// Copyright (C) 2016 David Reid. See included LICENSE file.
+
+// Command: dred -f findbench [Input File Name] [Options]
+//    -s String : The string to search for. Defaults to "return".
+//    -r Ratio  : The lowest throughput of the forward search as a fraction of strstr()'s that passes. Defaults to 0.5.
+//
+// Finds every occurrence of the string in the file with drte_engine_find(), forward, forward without case and backward, and prints
+// the throughput in MB/s next to that of strstr() on the same text, which is the baseline. Each search is run for at least half a
+// second. Fails with -6 when the forward search is slower than the ratio allows.
+//
+// Implementation: dred_findbench
+
+// pText is a copy of the engine's text for strstr() to search when it's not NULL, in which case options is ignored.
+double dred_findbench__run(drte_engine* pEngine, const char* pText, const char* pString, unsigned int options, size_t* pMatchCountOut)
+{
+    assert(pEngine != NULL);
+    assert(pString != NULL);
+    assert(pMatchCountOut != NULL);
+
+    size_t stringLength = strlen(pString);
+
+    dr_timer timer;
+    dr_timer_init(&timer);
+
+    double totalTime = 0;
+    size_t totalBytes = 0;
+    while (totalTime < 0.5 || totalBytes == 0) {
+        size_t matchCount = 0;
+        if (pText != NULL) {
+            const char* pMatch = strstr(pText, pString);
+            while (pMatch != NULL) {
+                matchCount += 1;
+                pMatch = strstr(pMatch + 1, pString);
+            }
+        } else if ((options & DRTE_FIND_BACKWARD) != 0) {
+            size_t iMatch;
+            size_t iChar = pEngine->textLength;
+            while (drte_engine_find(pEngine, pString, iChar, options, &iMatch)) {
+                matchCount += 1;
+                iChar = iMatch + stringLength - 1;
+            }
+        } else {
+            size_t iMatch;
+            size_t iChar = 0;
+            while (drte_engine_find(pEngine, pString, iChar, options, &iMatch)) {
+                matchCount += 1;
+                iChar = iMatch + 1;
+            }
+        }
+
+        *pMatchCountOut = matchCount;
+
+        totalBytes += pEngine->textLength;
+        totalTime += dr_timer_tick(&timer);
+
+        if (pEngine->textLength == 0) {
+            break;
+        }
+    }
+
+    if (totalTime == 0) {
+        return 0;
+    }
+
+    return (totalBytes / (1024.0*1024.0)) / totalTime;
+}
+
+// dred -f findbench
+int dred_findbench(int argc, char** argv)
+{
+    if (argc <= 1) {
+        return -1;  // No file specified.
+    }
+
+    const char* pString = "return";
+    double minRatio = 0.5;
+    for (int iarg = 2; iarg+1 < argc; iarg += 2) {
+        if (strcmp(argv[iarg], "-s") == 0) {
+            pString = argv[iarg+1];
+            if (pString[0] == '\0') {
+                return -3;
+            }
+        } else if (strcmp(argv[iarg], "-r") == 0) {
+            minRatio = atof(argv[iarg+1]);
+        }
+    }
+
+    size_t textLength;
+    char* pText = dr_open_and_read_text_file(argv[1], &textLength);
+    if (pText == NULL) {
+        return -2;  // Could not find file.
+    }
+
+    drte_engine engine;
+    if (!drte_engine_init(&engine, NULL)) {
+        dr_free_file_data(pText);
+        return -4;
+    }
+
+    drte_engine_set_text(&engine, pText);
+    dr_free_file_data(pText);
+
+    // The baseline searches the same text as the engine, after any changes drte_engine_set_text() made to it.
+    size_t engineTextLength = drte_engine_get_text(&engine, NULL, 0);
+    char* pEngineText = (char*)malloc(engineTextLength + 1);
+    if (pEngineText == NULL) {
+        drte_engine_uninit(&engine);
+        return -5;
+    }
+    drte_engine_get_text(&engine, pEngineText, engineTextLength + 1);
+
+    printf("%s: %.2f MB, \"%s\"\n", argv[1], engine.textLength / (1024.0*1024.0), pString);
+
+    size_t matchCount;
+    double throughput;
+
+    double baseline = dred_findbench__run(&engine, pEngineText, pString, 0, &matchCount);
+    printf("    %-18s %8.1f MB/s %10u matches\n", "strstr", baseline, (unsigned int)matchCount);
+
+    double forward = dred_findbench__run(&engine, NULL, pString, 0, &matchCount);
+    printf("    %-18s %8.1f MB/s %10u matches\n", "forward", forward, (unsigned int)matchCount);
+
+    throughput = dred_findbench__run(&engine, NULL, pString, DRTE_FIND_CASE_INSENSITIVE, &matchCount);
+    printf("    %-18s %8.1f MB/s %10u matches\n", "case-insensitive", throughput, (unsigned int)matchCount);
+
+    throughput = dred_findbench__run(&engine, NULL, pString, DRTE_FIND_BACKWARD, &matchCount);
+    printf("    %-18s %8.1f MB/s %10u matches\n", "backward", throughput, (unsigned int)matchCount);
+
+    free(pEngineText);
+    drte_engine_uninit(&engine);
+
+    double ratio = (baseline > 0) ? forward / baseline : 1;
+    if (ratio < minRatio) {
+        printf("FAIL: forward is %.2f of strstr, below %.2f\n", ratio, minRatio);
+        return -6;
+    }
+
+    printf("PASS: forward is %.2f of strstr\n", ratio);
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Copyright (C) 2016 David Reid. See included LICENSE file.
+
+// Command: dred -f glyphatlastest [Options]
+//    -font Family : The font family to draw with. Defaults to monospace, sans and serif in turn.
+//
+// Draws the same text onto two offscreen image surfaces, one created with dr2d_create_surface() which draws text from dr_2d's glyph
+// atlas, and one wrapping a cairo_t with dr2d_create_surface_cairo() which always draws text with cairo_show_glyphs(). Each case is
+// drawn with a different font size, weight, slant, color and clip, and the two surfaces are then compared pixel for pixel. Prints the
+// first differing pixel of each case that doesn't match and returns the number of those cases.
+//
+// The glyph atlas is only compiled in when DR2D_CAIRO_GLYPH_ATLAS is defined. Without it this returns -1.
+//
+// Implementation: dred_glyphatlastest
+
+#if !defined(DR2D_NO_CAIRO) && defined(DR2D_CAIRO_GLYPH_ATLAS)
+#define DRED_GLYPHATLASTEST_WIDTH   640
+#define DRED_GLYPHATLASTEST_HEIGHT  360
+
+typedef struct
+{
+    unsigned int fontSize;
+    dr2d_font_weight weight;
+    dr2d_font_slant slant;
+    dr2d_color color;
+    dr2d_color backgroundColor;
+    float posX;             // Negative to have the start of each line clipped by the left edge of the surface.
+    float clipLeft;         // The clip is ignored when clipRight is 0.
+    float clipTop;
+    float clipRight;
+    float clipBottom;
+} dred_glyphatlastest_case;
+
+static const char* g_GlyphAtlasTestLines[] = {
+    "The quick brown fox jumps over the lazy dog. 0123456789",
+    "int main(int argc, char** argv) { return argv[0][0] != '\\0'; }",
+    "ffi fl AV WAVE To Ty j/ gjpqy |[]{}()<> ~!@#$%^&*_+-=\\\"';:,./?",
+    "\xC3\xA9t\xC3\xA9 na\xC3\xAFve \xC3\xB1 \xC3\x9F \xE2\x80\x94 \xE2\x80\x9Cquotes\xE2\x80\x9D \xE2\x82\xAC \xCE\xB1\xCE\xB2\xCE\xB3 \xD0\xB4\xD0\xB0",
+    "\tTabs\tand  runs   of    spaces\tbetween\twords"
+};
+
+// Draws every line of text for the given case. The lines are spaced a little closer than the line height so that the ascenders and
+// descenders of neighbouring lines overlap.
+static void dred_glyphatlastest__draw(dr2d_surface* pSurface, dr2d_font* pFont, const dred_glyphatlastest_case* pCase)
+{
+    assert(pSurface != NULL);
+    assert(pFont != NULL);
+    assert(pCase != NULL);
+
+    dr2d_font_metrics metrics;
+    dr2d_get_font_metrics(pFont, &metrics);
+
+    dr2d_begin_draw(pSurface);
+    {
+        dr2d_set_clip(pSurface, 0, 0, DRED_GLYPHATLASTEST_WIDTH, DRED_GLYPHATLASTEST_HEIGHT);
+        dr2d_draw_rect(pSurface, 0, 0, DRED_GLYPHATLASTEST_WIDTH, DRED_GLYPHATLASTEST_HEIGHT, pCase->backgroundColor);
+
+        if (pCase->clipRight != 0) {
+            dr2d_set_clip(pSurface, pCase->clipLeft, pCase->clipTop, pCase->clipRight, pCase->clipBottom);
+        }
+
+        float posY = -(float)metrics.lineHeight / 2;
+        for (int iRepeat = 0; posY < DRED_GLYPHATLASTEST_HEIGHT; ++iRepeat) {
+            for (size_t iLine = 0; iLine < sizeof(g_GlyphAtlasTestLines) / sizeof(g_GlyphAtlasTestLines[0]) && posY < DRED_GLYPHATLASTEST_HEIGHT; ++iLine) {
+                const char* text = g_GlyphAtlasTestLines[iLine];
+
+                // Every second pass draws text with a transparent background over the text already there.
+                dr2d_color backgroundColor = pCase->backgroundColor;
+                if ((iRepeat & 1) != 0) {
+                    backgroundColor.a = 0;
+                }
+
+                dr2d_draw_text(pSurface, pFont, text, strlen(text), pCase->posX, posY, pCase->color, backgroundColor);
+                posY += (float)metrics.lineHeight - 2;
+            }
+        }
+    }
+    dr2d_end_draw(pSurface);
+}
+
+// Returns the number of pixels that differ between the two surfaces, and the position of the first one.
+static size_t dred_glyphatlastest__compare(cairo_surface_t* pSurface0, cairo_surface_t* pSurface1, int* pFirstXOut, int* pFirstYOut)
+{
+    assert(pSurface0 != NULL);
+    assert(pSurface1 != NULL);
+    assert(pFirstXOut != NULL);
+    assert(pFirstYOut != NULL);
+
+    cairo_surface_flush(pSurface0);
+    cairo_surface_flush(pSurface1);
+
+    const unsigned char* pData0 = cairo_image_surface_get_data(pSurface0);
+    const unsigned char* pData1 = cairo_image_surface_get_data(pSurface1);
+    int stride0 = cairo_image_surface_get_stride(pSurface0);
+    int stride1 = cairo_image_surface_get_stride(pSurface1);
+
+    size_t differenceCount = 0;
+    for (int y = 0; y < DRED_GLYPHATLASTEST_HEIGHT; ++y) {
+        const dr_uint32* pRow0 = (const dr_uint32*)(pData0 + y*stride0);
+        const dr_uint32* pRow1 = (const dr_uint32*)(pData1 + y*stride1);
+        for (int x = 0; x < DRED_GLYPHATLASTEST_WIDTH; ++x) {
+            if (pRow0[x] != pRow1[x]) {
+                if (differenceCount == 0) {
+                    *pFirstXOut = x;
+                    *pFirstYOut = y;
+                }
+
+                differenceCount += 1;
+            }
+        }
+    }
+
+    return differenceCount;
+}
+
+// dred -f glyphatlastest
+int dred_glyphatlastest(int argc, char** argv)
+{
+    const char* pFamilies[] = {"monospace", "sans", "serif"};
+    size_t familyCount = sizeof(pFamilies) / sizeof(pFamilies[0]);
+    for (int iarg = 1; iarg+1 < argc; iarg += 2) {
+        if (strcmp(argv[iarg], "-font") == 0) {
+            pFamilies[0] = argv[iarg+1];
+            familyCount = 1;
+        }
+    }
+
+    // Everything other than opaque text at whole pixel positions falls back to cairo_show_glyphs() on both surfaces, so those cases
+    // only check that the fallback is taken.
+    const dred_glyphatlastest_case cases[] = {
+        { 9, dr2d_font_weight_normal, dr2d_font_slant_none,   {  0,   0,   0, 255}, {255, 255, 255, 255},   0,   0,  0,   0,   0},
+        {13, dr2d_font_weight_normal, dr2d_font_slant_none,   {  0,   0,   0, 255}, {255, 255, 255, 255},   0,   0,  0,   0,   0},
+        {13, dr2d_font_weight_normal, dr2d_font_slant_none,   {220, 220, 204, 255}, { 48,  48,  48, 255},   4,   0,  0,   0,   0},
+        {13, dr2d_font_weight_bold,   dr2d_font_slant_none,   {255, 128,   0, 255}, { 32,  32,  64, 255},   0,   0,  0,   0,   0},
+        {13, dr2d_font_weight_normal, dr2d_font_slant_italic, { 64, 160,  64, 255}, {250, 250, 240, 255},   0,   0,  0,   0,   0},
+        {16, dr2d_font_weight_normal, dr2d_font_slant_none,   {  0,   0,   0, 255}, {255, 255, 255, 255}, -37,   0,  0,   0,   0},
+        {16, dr2d_font_weight_normal, dr2d_font_slant_none,   { 30,  30, 200, 255}, {255, 255, 255, 255},   2, 101, 53, 403, 211},
+        {27, dr2d_font_weight_bold,   dr2d_font_slant_italic, {255, 255, 255, 255}, {  0,   0,   0, 255}, -11,   0,  0,   0,   0},
+        {13, dr2d_font_weight_normal, dr2d_font_slant_none,   {  0,   0,   0, 128}, {255, 255, 255, 255},   0,   0,  0,   0,   0},
+        {13, dr2d_font_weight_normal, dr2d_font_slant_none,   {  0,   0,   0, 255}, {255, 255, 255, 255}, 0.5f,  0,  0,   0,   0},
+    };
+
+    dr2d_context* pContext = dr2d_create_context_cairo();
+    if (pContext == NULL) {
+        return -2;
+    }
+
+    int failedCount = 0;
+    for (size_t iFamily = 0; iFamily < familyCount; ++iFamily) {
+        for (size_t iCase = 0; iCase < sizeof(cases) / sizeof(cases[0]); ++iCase) {
+            const dred_glyphatlastest_case* pCase = &cases[iCase];
+
+            // The font is shared by both surfaces so that both draw the same glyphs. Only the surface created by dr_2d uses the atlas.
+            dr2d_font* pFont = dr2d_create_font(pContext, pFamilies[iFamily], pCase->fontSize, pCase->weight, pCase->slant, 0, 0);
+            dr2d_surface* pAtlasSurface = dr2d_create_surface(pContext, DRED_GLYPHATLASTEST_WIDTH, DRED_GLYPHATLASTEST_HEIGHT);
+
+            cairo_surface_t* pCairoSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, DRED_GLYPHATLASTEST_WIDTH, DRED_GLYPHATLASTEST_HEIGHT);
+            cairo_t* pCairoContext = cairo_create(pCairoSurface);
+            dr2d_surface* pCairoOnlySurface = dr2d_create_surface_cairo(pContext, pCairoContext);
+
+            if (pFont == NULL || pAtlasSurface == NULL || pCairoOnlySurface == NULL) {
+                printf("%-10s case %2u: could not create the font or surfaces\n", pFamilies[iFamily], (unsigned int)iCase);
+                failedCount += 1;
+            } else {
+                // Drawing twice makes the second pass find every glyph already in the atlas.
+                for (int iPass = 0; iPass < 2; ++iPass) {
+                    dred_glyphatlastest__draw(pAtlasSurface, pFont, pCase);
+                    dred_glyphatlastest__draw(pCairoOnlySurface, pFont, pCase);
+
+                    int firstX = 0;
+                    int firstY = 0;
+                    size_t differenceCount = dred_glyphatlastest__compare(dr2d_get_cairo_surface_t(pAtlasSurface), pCairoSurface, &firstX, &firstY);
+                    if (differenceCount > 0) {
+                        const dr_uint32* pAtlasPixel = (const dr_uint32*)(cairo_image_surface_get_data(dr2d_get_cairo_surface_t(pAtlasSurface)) + firstY*cairo_image_surface_get_stride(dr2d_get_cairo_surface_t(pAtlasSurface))) + firstX;
+                        const dr_uint32* pCairoPixel = (const dr_uint32*)(cairo_image_surface_get_data(pCairoSurface) + firstY*cairo_image_surface_get_stride(pCairoSurface)) + firstX;
+                        printf("%-10s case %2u pass %d: %u pixels differ, first at %d,%d (atlas %08X, cairo %08X)\n", pFamilies[iFamily], (unsigned int)iCase, iPass,
+                            (unsigned int)differenceCount, firstX, firstY, *pAtlasPixel, *pCairoPixel);
+                        failedCount += 1;
+                        break;
+                    }
+                }
+            }
+
+            dr2d_delete_surface(pCairoOnlySurface);
+            cairo_destroy(pCairoContext);
+            cairo_surface_destroy(pCairoSurface);
+            dr2d_delete_surface(pAtlasSurface);
+            dr2d_delete_font(pFont);
+        }
+    }
+
+    dr2d_delete_context(pContext);
+
+    if (failedCount == 0) {
+        printf("glyphatlastest: all %u cases are identical\n", (unsigned int)(familyCount * (sizeof(cases) / sizeof(cases[0]))));
+    }
+
+    return failedCount;
+}
+#else
+// dred -f glyphatlastest
+int dred_glyphatlastest(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    printf("glyphatlastest: dred was built without DR2D_CAIRO_GLYPH_ATLAS.\n");
+    return -1;
+}
+#endif
@@ -0,0 +1,92 @@
+// Copyright (C) 2016 David Reid. See included LICENSE file.
+
+// Command: dred -f lexbench [Input File Name] [Options]
+//    -l Language : Only benchmarks the given language, such as "cpp". Defaults to every language.
+//
+// Lexes the file one line at a time, the same way the highlighting thread does, with the lexer of each language and prints the
+// throughput in MB/s. Each language is run for at least half a second.
+//
+// Implementation: dred_lexbench
+
+double dred_lexbench__run(const dred_highlight_language* pLanguage, const char* pText, size_t textLength)
+{
+    assert(pLanguage != NULL);
+    assert(pText != NULL);
+
+    dred_highlight_result result;
+    memset(&result, 0, sizeof(result));
+
+    dr_timer timer;
+    dr_timer_init(&timer);
+
+    double totalTime = 0;
+    size_t totalBytes = 0;
+    while (totalTime < 0.5 || totalBytes == 0) {
+        uint32_t state = DRED_HIGHLIGHT_STATE_DEFAULT;
+        size_t iLineCharBeg = 0;
+        while (iLineCharBeg < textLength) {
+            size_t iLineCharEnd = iLineCharBeg;
+            while (iLineCharEnd < textLength && pText[iLineCharEnd] != '\n') {
+                iLineCharEnd += 1;
+            }
+            if (iLineCharEnd < textLength) {
+                iLineCharEnd += 1;
+            }
+
+            result.spanCount = 0;
+            state = dred_highlighter__lex_line(pLanguage, pText + iLineCharBeg, iLineCharEnd - iLineCharBeg, state, &result);
+
+            iLineCharBeg = iLineCharEnd;
+        }
+
+        totalBytes += textLength;
+        totalTime += dr_timer_tick(&timer);
+
+        if (textLength == 0) {
+            break;
+        }
+    }
+
+    free(result.pSpans);
+
+    if (totalTime == 0) {
+        return 0;
+    }
+
+    return (totalBytes / (1024.0*1024.0)) / totalTime;
+}
+
+// dred -f lexbench
+int dred_lexbench(int argc, char** argv)
+{
+    if (argc <= 1) {
+        return -1;  // No file specified.
+    }
+
+    const char* languageName = NULL;
+    if (argc > 3 && strcmp(argv[2], "-l") == 0) {
+        languageName = argv[3];
+        if (dred_find_highlight_language(languageName) == NULL) {
+            printf("Unknown language: %s\n", languageName);
+            return -3;
+        }
+    }
+
+    size_t textLength;
+    char* pText = dr_open_and_read_text_file(argv[1], &textLength);
+    if (pText == NULL) {
+        return -2;  // Could not find file.
+    }
+
+    printf("%s: %.2f MB\n", argv[1], textLength / (1024.0*1024.0));
+    for (size_t i = 0; i < DRED_LANGUAGE_COUNT; ++i) {
+        if (languageName != NULL && strcmp(g_Languages[i]->name, languageName) != 0) {
+            continue;
+        }
+
+        printf("    %-10s %8.1f MB/s\n", g_Languages[i]->name, dred_lexbench__run(g_Languages[i], pText, textLength));
+    }
+
+    dr_free_file_data(pText);
+    return 0;
+}
@@ -8,8 +8,12 @@ typedef struct
 } dred_cmdline_func_mapping;
 
 static dred_cmdline_func_mapping g_BuiltInCmdLineFuncs[] = {
-    {"file2chex",    dred_file2chex},
-    {"file2cstring", dred_file2cstring}
+    {"file2chex",      dred_file2chex},
+    {"file2cstring",   dred_file2cstring},
+    {"lexbench",       dred_lexbench},
+    {"findbench",      dred_findbench},
+    {"regextest",      dred_regextest},
+    {"glyphatlastest", dred_glyphatlastest}
 };
 
 
@@ -0,0 +1,167 @@
+// Copyright (C) 2016 David Reid. See included LICENSE file.
+
+// Command: dred -f regextest [Options]
+//    -n Length : The length of the generated text each pattern is run against. Defaults to 1000000.
+//
+// Runs the regex engine against patterns that are known to be slow with backtracking or that blow up the number of DFA states and
+// checks that each one finds the right match, or none, in less than DRED_REGEXTEST_TIME_LIMIT seconds. Also checks that invalid
+// and oversized patterns are rejected. Prints the time taken by each pattern and returns the number of failures.
+//
+// Implementation: dred_regextest
+
+#define DRED_REGEXTEST_TIME_LIMIT   2.0
+
+typedef enum
+{
+    dred_regextest_text_a,          // All a's.
+    dred_regextest_text_a_then_b,   // All a's, ending with a b.
+    dred_regextest_text_ab,         // Random a's and b's.
+    dred_regextest_text_words       // Random lower case letters other than x, with spaces and new lines.
+} dred_regextest_text;
+
+typedef struct
+{
+    const char* pattern;
+    dred_regextest_text text;
+    dr_bool32 isMatchExpected;
+    size_t iMatchBeg;   // (size_t)-1 for the length of the text.
+    size_t iMatchEnd;
+} dred_regextest_case;
+
+static dred_regextest_case g_RegexTestCases[] = {
+    {"(a*)*b",              dred_regextest_text_a,        DR_FALSE, 0, 0},
+    {"(a|a)*b",             dred_regextest_text_a,        DR_FALSE, 0, 0},
+    {"(a+a+)+b",            dred_regextest_text_a,        DR_FALSE, 0, 0},
+    {"(a|aa)*c",            dred_regextest_text_a,        DR_FALSE, 0, 0},
+    {"(?:a?){30}a{30}",     dred_regextest_text_a,        DR_TRUE,  0, 60},
+    {"(a*)*b",              dred_regextest_text_a_then_b, DR_TRUE,  0, (size_t)-1},
+    {"(a|b)*a(a|b){15}c",   dred_regextest_text_ab,       DR_FALSE, 0, 0},
+    {"(a|b)*a(a|b){12}$",   dred_regextest_text_ab,       DR_TRUE,  0, (size_t)-1},
+    {"[a-q][^u-z]{13}x",    dred_regextest_text_words,    DR_FALSE, 0, 0},
+    {"[a-q][^u-z]{20}x",    dred_regextest_text_words,    DR_FALSE, 0, 0}
+};
+
+static const char* g_RegexTestInvalidPatterns[] = {
+    "(", "(a", ")", "a)", "[a", "*a", "a{1001}", "a{3,2}", "(?", "\\",
+    "((((a{1000}){1000}){1000}))"
+};
+
+char* dred_regextest__generate_text(dred_regextest_text type, size_t length)
+{
+    char* pText = (char*)malloc(length + 1);
+    if (pText == NULL) {
+        return NULL;
+    }
+
+    const char* pAlphabet = "abcdefghijklmnopqrstuvwyz \n";
+    unsigned int seed = 1;
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed*1103515245 + 12345;
+        switch (type)
+        {
+            case dred_regextest_text_a:        pText[i] = 'a'; break;
+            case dred_regextest_text_a_then_b: pText[i] = (i+1 < length) ? 'a' : 'b'; break;
+            case dred_regextest_text_ab:       pText[i] = "ab"[(seed >> 16) & 1]; break;
+            case dred_regextest_text_words:    pText[i] = pAlphabet[(seed >> 16) % 27]; break;
+        }
+    }
+
+    pText[length] = '\0';
+    return pText;
+}
+
+dr_bool32 dred_regextest__run(drte_engine* pEngine, const dred_regextest_case* pCase)
+{
+    assert(pEngine != NULL);
+    assert(pCase != NULL);
+
+    drte_regex* pRegex = drte_regex_create(pCase->pattern, 0);
+    if (pRegex == NULL) {
+        printf("FAIL %-24s could not be compiled\n", pCase->pattern);
+        return DR_FALSE;
+    }
+
+    dr_timer timer;
+    dr_timer_init(&timer);
+
+    size_t iMatchBeg = 0;
+    size_t iMatchEnd = 0;
+    dr_bool32 isMatch = drte_engine_find_regex(pEngine, pRegex, 0, &iMatchBeg, &iMatchEnd);
+
+    // The groups are found by a different part of the engine so they're checked too.
+    dr_bool32 hasGroups = DR_TRUE;
+    if (isMatch) {
+        drte_region* pGroups = (drte_region*)malloc(sizeof(*pGroups) * (drte_regex_get_group_count(pRegex) + 1));
+        hasGroups = pGroups != NULL && drte_engine_get_regex_groups(pEngine, pRegex, iMatchBeg, iMatchEnd, pGroups);
+        free(pGroups);
+    }
+
+    double time = dr_timer_tick(&timer);
+    drte_regex_delete(pRegex);
+
+    size_t iExpectedMatchEnd = (pCase->iMatchEnd == (size_t)-1) ? pEngine->textLength : pCase->iMatchEnd;
+
+    dr_bool32 result = DR_TRUE;
+    if (isMatch != pCase->isMatchExpected || (isMatch && (iMatchBeg != pCase->iMatchBeg || iMatchEnd != iExpectedMatchEnd || !hasGroups))) {
+        result = DR_FALSE;
+    }
+    if (time > DRED_REGEXTEST_TIME_LIMIT) {
+        result = DR_FALSE;
+    }
+
+    printf("%s %-24s %8.3f s", (result) ? "PASS" : "FAIL", pCase->pattern, time);
+    if (isMatch) {
+        printf("    match [%u, %u)\n", (unsigned int)iMatchBeg, (unsigned int)iMatchEnd);
+    } else {
+        printf("    no match\n");
+    }
+
+    return result;
+}
+
+// dred -f regextest
+int dred_regextest(int argc, char** argv)
+{
+    size_t textLength = 1000000;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        textLength = (size_t)atoi(argv[2]);
+        if (textLength == 0) {
+            return -1;
+        }
+    }
+
+    drte_engine engine;
+    if (!drte_engine_init(&engine, NULL)) {
+        return -2;
+    }
+
+    int failedCount = 0;
+    for (size_t i = 0; i < sizeof(g_RegexTestCases) / sizeof(g_RegexTestCases[0]); ++i) {
+        char* pText = dred_regextest__generate_text(g_RegexTestCases[i].text, textLength);
+        if (pText == NULL) {
+            drte_engine_uninit(&engine);
+            return -3;
+        }
+
+        drte_engine_set_text(&engine, pText);
+        free(pText);
+
+        if (!dred_regextest__run(&engine, &g_RegexTestCases[i])) {
+            failedCount += 1;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(g_RegexTestInvalidPatterns) / sizeof(g_RegexTestInvalidPatterns[0]); ++i) {
+        drte_regex* pRegex = drte_regex_create(g_RegexTestInvalidPatterns[i], 0);
+        if (pRegex != NULL) {
+            printf("FAIL %-24s should have been rejected\n", g_RegexTestInvalidPatterns[i]);
+            drte_regex_delete(pRegex);
+            failedCount += 1;
+        }
+    }
+
+    drte_engine_uninit(&engine);
+
+    printf("%d failed\n", failedCount);
+    return failedCount;
+}
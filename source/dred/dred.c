@@ -75,4 +75,8 @@
 #include "dred_package_library.c"
 #include "cmdline_funcs/dred_file2chex.c"
 #include "cmdline_funcs/dred_file2cstring.c"
+#include "cmdline_funcs/dred_lexbench.c"
+#include "cmdline_funcs/dred_findbench.c"
+#include "cmdline_funcs/dred_regextest.c"
+#include "cmdline_funcs/dred_glyphatlastest.c"
 #include "cmdline_funcs/dred_main_f.c"
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 
 // Commands
-#define DRED_COMMAND_COUNT 53
+#define DRED_COMMAND_COUNT 56
 
 const char g_CommandNamePool[] = 
     "!\0"
@@ -50,6 +50,9 @@ const char g_CommandNamePool[] =
     "find\0"
     "replace\0"
     "replace-all\0"
+    "find-regex\0"
+    "replace-regex\0"
+    "replace-all-regex\0"
     "show-line-numbers\0"
     "hide-line-numbers\0"
     "toggle-line-numbers\0"
@@ -106,15 +109,18 @@ const char* g_CommandNames[] = {
     g_CommandNamePool + 364,
     g_CommandNamePool + 372,
     g_CommandNamePool + 384,
-    g_CommandNamePool + 402,
-    g_CommandNamePool + 420,
-    g_CommandNamePool + 440,
-    g_CommandNamePool + 457,
-    g_CommandNamePool + 462,
-    g_CommandNamePool + 471,
+    g_CommandNamePool + 395,
+    g_CommandNamePool + 409,
+    g_CommandNamePool + 427,
+    g_CommandNamePool + 445,
+    g_CommandNamePool + 463,
     g_CommandNamePool + 483,
-    g_CommandNamePool + 498,
-    g_CommandNamePool + 512,
+    g_CommandNamePool + 500,
+    g_CommandNamePool + 505,
+    g_CommandNamePool + 514,
+    g_CommandNamePool + 526,
+    g_CommandNamePool + 541,
+    g_CommandNamePool + 555,
 };
 
 dred_command g_Commands[] = {
@@ -161,6 +167,9 @@ dred_command g_Commands[] = {
     {dred_command__find, DRED_CMDBAR_NO_CLEAR},
     {dred_command__replace, DRED_CMDBAR_NO_CLEAR},
     {dred_command__replace_all, DRED_CMDBAR_RELEASE_KEYBOARD},
+    {dred_command__find_regex, DRED_CMDBAR_NO_CLEAR},
+    {dred_command__replace_regex, DRED_CMDBAR_NO_CLEAR},
+    {dred_command__replace_all_regex, DRED_CMDBAR_RELEASE_KEYBOARD},
     {dred_command__show_line_numbers, DRED_CMDBAR_RELEASE_KEYBOARD},
     {dred_command__hide_line_numbers, DRED_CMDBAR_RELEASE_KEYBOARD},
     {dred_command__toggle_line_numbers, DRED_CMDBAR_RELEASE_KEYBOARD},
@@ -1899,3 +1908,692 @@ void dred_config_set_default__autogenerated(dred_config* pConfig, const char* ke
     }
 }
 
+
+
+// Languages
+dred_highlight_keyword g_KeywordTableC_Keywords[] = {
+    {"int16_t", 7, dred_highlight_category_datatype},
+    {"int8_t", 6, dred_highlight_category_datatype},
+    {"default", 7, dred_highlight_category_instruction},
+    {"void", 4, dred_highlight_category_datatype},
+    {"double", 6, dred_highlight_category_datatype},
+    {"else", 4, dred_highlight_category_instruction},
+    {"FILE", 4, dred_highlight_category_datatype},
+    {"_Imaginary", 10, dred_highlight_category_datatype},
+    {"unsigned", 8, dred_highlight_category_datatype},
+    {"_Generic", 8, dred_highlight_category_instruction},
+    {"enum", 4, dred_highlight_category_datatype},
+    {"return", 6, dred_highlight_category_instruction},
+    {"_Static_assert", 14, dred_highlight_category_instruction},
+    {"size_t", 6, dred_highlight_category_datatype},
+    {"restrict", 8, dred_highlight_category_datatype},
+    {"break", 5, dred_highlight_category_instruction},
+    {"_Noreturn", 9, dred_highlight_category_datatype},
+    {"intmax_t", 8, dred_highlight_category_datatype},
+    {"float", 5, dred_highlight_category_datatype},
+    {"auto", 4, dred_highlight_category_datatype},
+    {"for", 3, dred_highlight_category_instruction},
+    {"while", 5, dred_highlight_category_instruction},
+    {"_Alignas", 8, dred_highlight_category_datatype},
+    {"inline", 6, dred_highlight_category_datatype},
+    {"struct", 6, dred_highlight_category_datatype},
+    {"goto", 4, dred_highlight_category_instruction},
+    {"uintptr_t", 9, dred_highlight_category_datatype},
+    {"ptrdiff_t", 9, dred_highlight_category_datatype},
+    {"uint32_t", 8, dred_highlight_category_datatype},
+    {"sizeof", 6, dred_highlight_category_instruction},
+    {"long", 4, dred_highlight_category_datatype},
+    {"_Atomic", 7, dred_highlight_category_datatype},
+    {"_Complex", 8, dred_highlight_category_datatype},
+    {"static", 6, dred_highlight_category_datatype},
+    {"wchar_t", 7, dred_highlight_category_datatype},
+    {"do", 2, dred_highlight_category_instruction},
+    {"signed", 6, dred_highlight_category_datatype},
+    {"if", 2, dred_highlight_category_instruction},
+    {"int32_t", 7, dred_highlight_category_datatype},
+    {"bool", 4, dred_highlight_category_datatype},
+    {"short", 5, dred_highlight_category_datatype},
+    {"_Bool", 5, dred_highlight_category_datatype},
+    {"uint16_t", 8, dred_highlight_category_datatype},
+    {"extern", 6, dred_highlight_category_datatype},
+    {"_Alignof", 8, dred_highlight_category_instruction},
+    {"intptr_t", 8, dred_highlight_category_datatype},
+    {"register", 8, dred_highlight_category_datatype},
+    {"char", 4, dred_highlight_category_datatype},
+    {"union", 5, dred_highlight_category_datatype},
+    {"int64_t", 7, dred_highlight_category_datatype},
+    {"uintmax_t", 9, dred_highlight_category_datatype},
+    {"volatile", 8, dred_highlight_category_datatype},
+    {"_Thread_local", 13, dred_highlight_category_datatype},
+    {"switch", 6, dred_highlight_category_instruction},
+    {"uint8_t", 7, dred_highlight_category_datatype},
+    {"va_list", 7, dred_highlight_category_datatype},
+    {"continue", 8, dred_highlight_category_instruction},
+    {"uint64_t", 8, dred_highlight_category_datatype},
+    {"const", 5, dred_highlight_category_datatype},
+    {"int", 3, dred_highlight_category_datatype},
+    {"typedef", 7, dred_highlight_category_datatype},
+    {"case", 4, dred_highlight_category_instruction},
+};
+
+uint16_t g_KeywordTableC_Displacements[] = {
+    1, 0, 5, 14, 4, 8, 0, 1, 2, 12, 0, 0, 30, 0, 3, 2,
+    9, 2, 13, 53, 0, 0, 0, 16, 62, 173, 64, 118, 6, 32, 0, 0,
+};
+
+dred_highlight_keyword_table g_KeywordTableC = {g_KeywordTableC_Keywords, 62, g_KeywordTableC_Displacements, 32};
+
+uint8_t g_LexerC_CharClasses[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 0, 0, 0, 0, 3, 0, 0, 4, 0, 0, 0, 0, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 8, 0, 0, 7,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+uint16_t g_LexerC_Transitions[] = {
+    0x8001, 0x8001, 0x8002, 0x8003, 0x8001, 0x8004, 0x8005, 0x8006, 0x8001,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8009, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0x800B, 0xFFFF, 0x800B, 0x800C, 0x800B, 0x800B, 0x800B, 0x800B, 0x800D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800E, 0x800F, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8011, 0x8011, 0xFFFF,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8009, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008,
+    0x800B, 0xFFFF, 0x800B, 0x800C, 0x800B, 0x800B, 0x800B, 0x800B, 0x800D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x8012, 0x800E, 0x800E, 0x800E, 0x800E,
+    0x800F, 0xFFFF, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8011, 0x8011, 0xFFFF,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x8012, 0x8013, 0x800E, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+};
+
+uint8_t g_LexerC_StateCategories[] = {
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_comment, dred_highlight_category_comment,
+};
+
+uint8_t g_LexerC_StateFlags[] = {
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 1, 2, 0,
+};
+
+const char* g_LanguageC_Extensions[] = {"c", "h", NULL};
+
+dred_highlight_language g_LanguageC = {"c", g_LanguageC_Extensions, 20, 9, g_LexerC_CharClasses, g_LexerC_Transitions, g_LexerC_StateCategories, g_LexerC_StateFlags, &g_KeywordTableC};
+
+dred_highlight_keyword g_KeywordTableCpp_Keywords[] = {
+    {"final", 5, dred_highlight_category_datatype},
+    {"int64_t", 7, dred_highlight_category_datatype},
+    {"decltype", 8, dred_highlight_category_instruction},
+    {"catch", 5, dred_highlight_category_instruction},
+    {"uint8_t", 7, dred_highlight_category_datatype},
+    {"intmax_t", 8, dred_highlight_category_datatype},
+    {"size_t", 6, dred_highlight_category_datatype},
+    {"static", 6, dred_highlight_category_datatype},
+    {"bool", 4, dred_highlight_category_datatype},
+    {"do", 2, dred_highlight_category_instruction},
+    {"int", 3, dred_highlight_category_datatype},
+    {"nullptr_t", 9, dred_highlight_category_datatype},
+    {"const_cast", 10, dred_highlight_category_instruction},
+    {"alignas", 7, dred_highlight_category_datatype},
+    {"this", 4, dred_highlight_category_instruction},
+    {"static_assert", 13, dred_highlight_category_instruction},
+    {"long", 4, dred_highlight_category_datatype},
+    {"explicit", 8, dred_highlight_category_datatype},
+    {"dynamic_cast", 12, dred_highlight_category_instruction},
+    {"extern", 6, dred_highlight_category_datatype},
+    {"char32_t", 8, dred_highlight_category_datatype},
+    {"namespace", 9, dred_highlight_category_datatype},
+    {"void", 4, dred_highlight_category_datatype},
+    {"float", 5, dred_highlight_category_datatype},
+    {"case", 4, dred_highlight_category_instruction},
+    {"uint64_t", 8, dred_highlight_category_datatype},
+    {"try", 3, dred_highlight_category_instruction},
+    {"reinterpret_cast", 16, dred_highlight_category_instruction},
+    {"uint32_t", 8, dred_highlight_category_datatype},
+    {"ptrdiff_t", 9, dred_highlight_category_datatype},
+    {"int16_t", 7, dred_highlight_category_datatype},
+    {"uintptr_t", 9, dred_highlight_category_datatype},
+    {"delete", 6, dred_highlight_category_instruction},
+    {"operator", 8, dred_highlight_category_instruction},
+    {"intptr_t", 8, dred_highlight_category_datatype},
+    {"register", 8, dred_highlight_category_datatype},
+    {"unsigned", 8, dred_highlight_category_datatype},
+    {"constexpr", 9, dred_highlight_category_datatype},
+    {"new", 3, dred_highlight_category_instruction},
+    {"return", 6, dred_highlight_category_instruction},
+    {"static_cast", 11, dred_highlight_category_instruction},
+    {"template", 8, dred_highlight_category_datatype},
+    {"using", 5, dred_highlight_category_datatype},
+    {"break", 5, dred_highlight_category_instruction},
+    {"true", 4, dred_highlight_category_instruction},
+    {"private", 7, dred_highlight_category_datatype},
+    {"wchar_t", 7, dred_highlight_category_datatype},
+    {"while", 5, dred_highlight_category_instruction},
+    {"volatile", 8, dred_highlight_category_datatype},
+    {"enum", 4, dred_highlight_category_datatype},
+    {"short", 5, dred_highlight_category_datatype},
+    {"int8_t", 6, dred_highlight_category_datatype},
+    {"else", 4, dred_highlight_category_instruction},
+    {"typedef", 7, dred_highlight_category_datatype},
+    {"friend", 6, dred_highlight_category_datatype},
+    {"noexcept", 8, dred_highlight_category_datatype},
+    {"sizeof", 6, dred_highlight_category_instruction},
+    {"alignof", 7, dred_highlight_category_instruction},
+    {"class", 5, dred_highlight_category_datatype},
+    {"throw", 5, dred_highlight_category_instruction},
+    {"inline", 6, dred_highlight_category_datatype},
+    {"char16_t", 8, dred_highlight_category_datatype},
+    {"default", 7, dred_highlight_category_instruction},
+    {"thread_local", 12, dred_highlight_category_datatype},
+    {"struct", 6, dred_highlight_category_datatype},
+    {"signed", 6, dred_highlight_category_datatype},
+    {"nullptr", 7, dred_highlight_category_instruction},
+    {"public", 6, dred_highlight_category_datatype},
+    {"override", 8, dred_highlight_category_datatype},
+    {"for", 3, dred_highlight_category_instruction},
+    {"if", 2, dred_highlight_category_instruction},
+    {"goto", 4, dred_highlight_category_instruction},
+    {"typeid", 6, dred_highlight_category_instruction},
+    {"protected", 9, dred_highlight_category_datatype},
+    {"uint16_t", 8, dred_highlight_category_datatype},
+    {"union", 5, dred_highlight_category_datatype},
+    {"switch", 6, dred_highlight_category_instruction},
+    {"auto", 4, dred_highlight_category_datatype},
+    {"continue", 8, dred_highlight_category_instruction},
+    {"int32_t", 7, dred_highlight_category_datatype},
+    {"typename", 8, dred_highlight_category_datatype},
+    {"uintmax_t", 9, dred_highlight_category_datatype},
+    {"char", 4, dred_highlight_category_datatype},
+    {"mutable", 7, dred_highlight_category_datatype},
+    {"const", 5, dred_highlight_category_datatype},
+    {"false", 5, dred_highlight_category_instruction},
+    {"double", 6, dred_highlight_category_datatype},
+    {"virtual", 7, dred_highlight_category_datatype},
+};
+
+uint16_t g_KeywordTableCpp_Displacements[] = {
+    0, 10, 0, 0, 11, 20, 3, 0, 1, 0, 24, 20, 0, 2, 0, 6,
+    0, 2, 27, 3, 5, 0, 10, 20, 22, 2, 48, 3, 24, 12, 0, 24,
+    26, 49, 4, 0, 0, 0, 18, 112, 0, 12, 4, 6, 0,
+};
+
+dred_highlight_keyword_table g_KeywordTableCpp = {g_KeywordTableCpp_Keywords, 88, g_KeywordTableCpp_Displacements, 45};
+
+uint8_t g_LexerCpp_CharClasses[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 0, 0, 0, 0, 3, 0, 0, 4, 0, 0, 0, 0, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 8, 0, 0, 7,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+uint16_t g_LexerCpp_Transitions[] = {
+    0x8001, 0x8001, 0x8002, 0x8003, 0x8001, 0x8004, 0x8005, 0x8006, 0x8001,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8009, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0x800B, 0xFFFF, 0x800B, 0x800C, 0x800B, 0x800B, 0x800B, 0x800B, 0x800D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800E, 0x800F, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8011, 0x8011, 0xFFFF,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8009, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008,
+    0x800B, 0xFFFF, 0x800B, 0x800C, 0x800B, 0x800B, 0x800B, 0x800B, 0x800D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x8012, 0x800E, 0x800E, 0x800E, 0x800E,
+    0x800F, 0xFFFF, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F, 0x800F,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8011, 0x8011, 0xFFFF,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x8012, 0x8013, 0x800E, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+};
+
+uint8_t g_LexerCpp_StateCategories[] = {
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_comment, dred_highlight_category_comment,
+};
+
+uint8_t g_LexerCpp_StateFlags[] = {
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 1, 2, 0,
+};
+
+const char* g_LanguageCpp_Extensions[] = {"cpp", "cc", "cxx", "hpp", "hh", "hxx", "inl", NULL};
+
+dred_highlight_language g_LanguageCpp = {"cpp", g_LanguageCpp_Extensions, 20, 9, g_LexerCpp_CharClasses, g_LexerCpp_Transitions, g_LexerCpp_StateCategories, g_LexerCpp_StateFlags, &g_KeywordTableCpp};
+
+dred_highlight_keyword g_KeywordTablePython_Keywords[] = {
+    {"True", 4, dred_highlight_category_datatype},
+    {"or", 2, dred_highlight_category_instruction},
+    {"not", 3, dred_highlight_category_instruction},
+    {"as", 2, dred_highlight_category_instruction},
+    {"list", 4, dred_highlight_category_datatype},
+    {"bytearray", 9, dred_highlight_category_datatype},
+    {"with", 4, dred_highlight_category_instruction},
+    {"assert", 6, dred_highlight_category_instruction},
+    {"and", 3, dred_highlight_category_instruction},
+    {"except", 6, dred_highlight_category_instruction},
+    {"del", 3, dred_highlight_category_instruction},
+    {"None", 4, dred_highlight_category_datatype},
+    {"elif", 4, dred_highlight_category_instruction},
+    {"for", 3, dred_highlight_category_instruction},
+    {"def", 3, dred_highlight_category_instruction},
+    {"await", 5, dred_highlight_category_instruction},
+    {"lambda", 6, dred_highlight_category_instruction},
+    {"return", 6, dred_highlight_category_instruction},
+    {"type", 4, dred_highlight_category_datatype},
+    {"try", 3, dred_highlight_category_instruction},
+    {"in", 2, dred_highlight_category_instruction},
+    {"nonlocal", 8, dred_highlight_category_instruction},
+    {"while", 5, dred_highlight_category_instruction},
+    {"bytes", 5, dred_highlight_category_datatype},
+    {"else", 4, dred_highlight_category_instruction},
+    {"float", 5, dred_highlight_category_datatype},
+    {"str", 3, dred_highlight_category_datatype},
+    {"continue", 8, dred_highlight_category_instruction},
+    {"break", 5, dred_highlight_category_instruction},
+    {"finally", 7, dred_highlight_category_instruction},
+    {"async", 5, dred_highlight_category_instruction},
+    {"set", 3, dred_highlight_category_datatype},
+    {"frozenset", 9, dred_highlight_category_datatype},
+    {"False", 5, dred_highlight_category_datatype},
+    {"import", 6, dred_highlight_category_instruction},
+    {"bool", 4, dred_highlight_category_datatype},
+    {"yield", 5, dred_highlight_category_instruction},
+    {"dict", 4, dred_highlight_category_datatype},
+    {"cls", 3, dred_highlight_category_datatype},
+    {"pass", 4, dred_highlight_category_instruction},
+    {"tuple", 5, dred_highlight_category_datatype},
+    {"int", 3, dred_highlight_category_datatype},
+    {"if", 2, dred_highlight_category_instruction},
+    {"complex", 7, dred_highlight_category_datatype},
+    {"is", 2, dred_highlight_category_instruction},
+    {"object", 6, dred_highlight_category_datatype},
+    {"raise", 5, dred_highlight_category_instruction},
+    {"class", 5, dred_highlight_category_instruction},
+    {"from", 4, dred_highlight_category_instruction},
+    {"self", 4, dred_highlight_category_datatype},
+    {"global", 6, dred_highlight_category_instruction},
+};
+
+uint16_t g_KeywordTablePython_Displacements[] = {
+    0, 9, 7, 8, 1, 6, 16, 0, 1, 1, 1, 33, 0, 1, 3, 0,
+    0, 33, 4, 2, 6, 9, 0, 48, 1, 14,
+};
+
+dred_highlight_keyword_table g_KeywordTablePython = {g_KeywordTablePython_Keywords, 51, g_KeywordTablePython_Displacements, 26};
+
+uint8_t g_LexerPython_CharClasses[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 3, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 0, 0, 0, 0, 0, 0,
+    0, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 7, 0, 0, 6,
+    0, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+uint16_t g_LexerPython_Transitions[] = {
+    0x8001, 0x8001, 0x8002, 0x8003, 0x8004, 0x8005, 0x8006, 0x8001,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8009, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0x800B, 0xFFFF, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B,
+    0x800C, 0xFFFF, 0x800C, 0x800C, 0x800D, 0x800C, 0x800C, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0x8007, 0x8007, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8007,
+    0x8008, 0xFFFF, 0x8011, 0x8008, 0x8008, 0x8008, 0x8008, 0x800A,
+    0xFFFF, 0xFFFF, 0x8012, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008, 0x8008,
+    0x800B, 0xFFFF, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B, 0x800B,
+    0x800C, 0xFFFF, 0x800C, 0x800C, 0x8013, 0x800C, 0x800C, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8014, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x800C, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8010, 0x8010, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8012, 0x8012, 0x8015, 0x8012, 0x8012, 0x8012, 0x8012, 0x8016,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8014, 0x8014, 0x8014, 0x8014, 0x8017, 0x8014, 0x8014, 0x8018,
+    0x8012, 0x8012, 0x8019, 0x8012, 0x8012, 0x8012, 0x8012, 0x8016,
+    0x8012, 0x8012, 0x8012, 0x8012, 0x8012, 0x8012, 0x8012, 0x8012,
+    0x8014, 0x8014, 0x8014, 0x8014, 0x801A, 0x8014, 0x8014, 0x8018,
+    0x8014, 0x8014, 0x8014, 0x8014, 0x8014, 0x8014, 0x8014, 0x8014,
+    0x8012, 0x8012, 0x801B, 0x8012, 0x8012, 0x8012, 0x8012, 0x8016,
+    0x8014, 0x8014, 0x8014, 0x8014, 0x801C, 0x8014, 0x8014, 0x8018,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+};
+
+uint8_t g_LexerPython_StateCategories[] = {
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_comment,
+    dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_default,
+    dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string,
+};
+
+uint8_t g_LexerPython_StateFlags[] = {
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 2, 0, 2, 2, 2, 2, 2, 2, 2, 0, 0,
+};
+
+const char* g_LanguagePython_Extensions[] = {"py", "pyw", NULL};
+
+dred_highlight_language g_LanguagePython = {"python", g_LanguagePython_Extensions, 29, 8, g_LexerPython_CharClasses, g_LexerPython_Transitions, g_LexerPython_StateCategories, g_LexerPython_StateFlags, &g_KeywordTablePython};
+
+dred_highlight_keyword g_KeywordTableRust_Keywords[] = {
+    {"u16", 3, dred_highlight_category_datatype},
+    {"fn", 2, dred_highlight_category_datatype},
+    {"super", 5, dred_highlight_category_instruction},
+    {"static", 6, dred_highlight_category_datatype},
+    {"isize", 5, dred_highlight_category_datatype},
+    {"i128", 4, dred_highlight_category_datatype},
+    {"u32", 3, dred_highlight_category_datatype},
+    {"ref", 3, dred_highlight_category_instruction},
+    {"impl", 4, dred_highlight_category_datatype},
+    {"trait", 5, dred_highlight_category_datatype},
+    {"mut", 3, dred_highlight_category_datatype},
+    {"Vec", 3, dred_highlight_category_datatype},
+    {"u8", 2, dred_highlight_category_datatype},
+    {"for", 3, dred_highlight_category_instruction},
+    {"Some", 4, dred_highlight_category_datatype},
+    {"Err", 3, dred_highlight_category_datatype},
+    {"true", 4, dred_highlight_category_instruction},
+    {"extern", 6, dred_highlight_category_datatype},
+    {"move", 4, dred_highlight_category_instruction},
+    {"None", 4, dred_highlight_category_datatype},
+    {"char", 4, dred_highlight_category_datatype},
+    {"break", 5, dred_highlight_category_instruction},
+    {"as", 2, dred_highlight_category_instruction},
+    {"Self", 4, dred_highlight_category_datatype},
+    {"i8", 2, dred_highlight_category_datatype},
+    {"await", 5, dred_highlight_category_instruction},
+    {"in", 2, dred_highlight_category_instruction},
+    {"bool", 4, dred_highlight_category_datatype},
+    {"String", 6, dred_highlight_category_datatype},
+    {"return", 6, dred_highlight_category_instruction},
+    {"dyn", 3, dred_highlight_category_datatype},
+    {"u128", 4, dred_highlight_category_datatype},
+    {"i64", 3, dred_highlight_category_datatype},
+    {"const", 5, dred_highlight_category_datatype},
+    {"f32", 3, dred_highlight_category_datatype},
+    {"union", 5, dred_highlight_category_datatype},
+    {"match", 5, dred_highlight_category_instruction},
+    {"i32", 3, dred_highlight_category_datatype},
+    {"pub", 3, dred_highlight_category_datatype},
+    {"loop", 4, dred_highlight_category_instruction},
+    {"else", 4, dred_highlight_category_instruction},
+    {"f64", 3, dred_highlight_category_datatype},
+    {"mod", 3, dred_highlight_category_datatype},
+    {"where", 5, dred_highlight_category_instruction},
+    {"false", 5, dred_highlight_category_instruction},
+    {"use", 3, dred_highlight_category_instruction},
+    {"crate", 5, dred_highlight_category_datatype},
+    {"unsafe", 6, dred_highlight_category_datatype},
+    {"struct", 6, dred_highlight_category_datatype},
+    {"Ok", 2, dred_highlight_category_datatype},
+    {"str", 3, dred_highlight_category_datatype},
+    {"Box", 3, dred_highlight_category_datatype},
+    {"continue", 8, dred_highlight_category_instruction},
+    {"Option", 6, dred_highlight_category_datatype},
+    {"if", 2, dred_highlight_category_instruction},
+    {"Result", 6, dred_highlight_category_datatype},
+    {"async", 5, dred_highlight_category_instruction},
+    {"enum", 4, dred_highlight_category_datatype},
+    {"i16", 3, dred_highlight_category_datatype},
+    {"u64", 3, dred_highlight_category_datatype},
+    {"let", 3, dred_highlight_category_instruction},
+    {"self", 4, dred_highlight_category_datatype},
+    {"while", 5, dred_highlight_category_instruction},
+    {"usize", 5, dred_highlight_category_datatype},
+    {"type", 4, dred_highlight_category_datatype},
+};
+
+uint16_t g_KeywordTableRust_Displacements[] = {
+    6, 0, 0, 0, 0, 0, 0, 3, 5, 7, 1, 2, 1, 52, 0, 20,
+    9, 11, 8, 0, 0, 2, 27, 9, 26, 14, 0, 80, 27, 0, 8, 22,
+    47,
+};
+
+dred_highlight_keyword_table g_KeywordTableRust = {g_KeywordTableRust_Keywords, 65, g_KeywordTableRust_Displacements, 33};
+
+uint8_t g_LexerRust_CharClasses[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 3, 0, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 8, 0, 0, 7,
+    0, 7, 9, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 10, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+uint16_t g_LexerRust_Transitions[] = {
+    0x8001, 0x8001, 0x8002, 0x8001, 0x8001, 0x8003, 0x8004, 0x8005, 0x8001, 0x8006, 0x8007,
+    0x8008, 0x8008, 0xFFFF, 0x8008, 0x8008, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF, 0xFFFF,
+    0x8009, 0x8009, 0x800A, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x800B, 0x8009, 0x8009,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800C, 0x800D, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800E, 0x800E, 0xFFFF, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF, 0x800F, 0x800F,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF, 0x800F, 0x8010,
+    0xFFFF, 0xFFFF, 0x8011, 0x0012, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF, 0x800F, 0x800F,
+    0x8008, 0x8008, 0xFFFF, 0x8008, 0x8008, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF, 0xFFFF,
+    0x8009, 0x8009, 0x800A, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x800B, 0x8009, 0x8009,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009, 0x8009,
+    0x800C, 0x800C, 0x800C, 0x800C, 0x8013, 0x8014, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C,
+    0x800D, 0xFFFF, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800E, 0x800E, 0xFFFF, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF, 0x800F, 0x800F,
+    0xFFFF, 0xFFFF, 0x8015, 0x0016, 0xFFFF, 0xFFFF, 0x800F, 0x800F, 0xFFFF, 0x800F, 0x800F,
+    0x8011, 0x8011, 0x8017, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011,
+    0xFFFF, 0xFFFF, 0x8018, 0x0019, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x800C, 0x800C, 0x800C, 0x800C, 0x8013, 0x801A, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C,
+    0x800C, 0x800C, 0x800C, 0x800C, 0x801B, 0x8014, 0x800C, 0x800C, 0x800C, 0x800C, 0x800C,
+    0x8015, 0x8015, 0x801C, 0x8015, 0x8015, 0x8015, 0x8015, 0x8015, 0x8015, 0x8015, 0x8015,
+    0xFFFF, 0xFFFF, 0x801D, 0x001E, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8018, 0x8018, 0x801F, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018,
+    0xFFFF, 0xFFFF, 0x8020, 0x0021, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x801B, 0x801B, 0x801B, 0x801B, 0x8022, 0x8023, 0x801B, 0x801B, 0x801B, 0x801B, 0x801B,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x801D, 0x801D, 0x8024, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D,
+    0xFFFF, 0xFFFF, 0x8025, 0x0026, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8018, 0x8018, 0x801F, 0x8027, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018, 0x8018,
+    0x8020, 0x8020, 0x8028, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020,
+    0xFFFF, 0xFFFF, 0x8029, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x801B, 0x801B, 0x801B, 0x801B, 0x8022, 0x800C, 0x801B, 0x801B, 0x801B, 0x801B, 0x801B,
+    0x801B, 0x801B, 0x801B, 0x801B, 0x802A, 0x8023, 0x801B, 0x801B, 0x801B, 0x801B, 0x801B,
+    0x801D, 0x801D, 0x8024, 0x802B, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D, 0x801D,
+    0x8025, 0x8025, 0x802C, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025,
+    0xFFFF, 0xFFFF, 0x802D, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8020, 0x8020, 0x8028, 0x802E, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020,
+    0x8029, 0x8029, 0x802F, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029,
+    0x802A, 0x802A, 0x802A, 0x802A, 0x8030, 0x8031, 0x802A, 0x802A, 0x802A, 0x802A, 0x802A,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8025, 0x8025, 0x802C, 0x8032, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025,
+    0x802D, 0x802D, 0x8033, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D,
+    0x8020, 0x8020, 0x8028, 0x8034, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020, 0x8020,
+    0x8029, 0x8029, 0x802F, 0x8035, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029,
+    0x802A, 0x802A, 0x802A, 0x802A, 0x8030, 0x801B, 0x802A, 0x802A, 0x802A, 0x802A, 0x802A,
+    0x802A, 0x802A, 0x802A, 0x802A, 0x8036, 0x8031, 0x802A, 0x802A, 0x802A, 0x802A, 0x802A,
+    0x8025, 0x8025, 0x802C, 0x8037, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025, 0x8025,
+    0x802D, 0x802D, 0x8033, 0x8038, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x8029, 0x8029, 0x802F, 0x8039, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029,
+    0x8036, 0x8036, 0x8036, 0x8036, 0x803A, 0x803B, 0x8036, 0x8036, 0x8036, 0x8036, 0x8036,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x802D, 0x802D, 0x8033, 0x803C, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D,
+    0x8029, 0x8029, 0x802F, 0x803D, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029, 0x8029,
+    0x8036, 0x8036, 0x8036, 0x8036, 0x803A, 0x802A, 0x8036, 0x8036, 0x8036, 0x8036, 0x8036,
+    0x8036, 0x8036, 0x8036, 0x8036, 0x803E, 0x803B, 0x8036, 0x8036, 0x8036, 0x8036, 0x8036,
+    0x802D, 0x802D, 0x8033, 0x803F, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D, 0x802D,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x803E, 0x803E, 0x803E, 0x803E, 0x8040, 0x8041, 0x803E, 0x803E, 0x803E, 0x803E, 0x803E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x803E, 0x803E, 0x803E, 0x803E, 0x8040, 0x8036, 0x803E, 0x803E, 0x803E, 0x803E, 0x803E,
+    0x803E, 0x803E, 0x803E, 0x803E, 0x8042, 0x8041, 0x803E, 0x803E, 0x803E, 0x803E, 0x803E,
+    0x8042, 0x8042, 0x8042, 0x8042, 0x8043, 0x8044, 0x8042, 0x8042, 0x8042, 0x8042, 0x8042,
+    0x8042, 0x8042, 0x8042, 0x8042, 0x8043, 0x803E, 0x8042, 0x8042, 0x8042, 0x8042, 0x8042,
+    0x8042, 0x8042, 0x8042, 0x8042, 0x8045, 0x8044, 0x8042, 0x8042, 0x8042, 0x8042, 0x8042,
+    0x8045, 0x8045, 0x8045, 0x8045, 0x8046, 0x8047, 0x8045, 0x8045, 0x8045, 0x8045, 0x8045,
+    0x8045, 0x8045, 0x8045, 0x8045, 0x8046, 0x8042, 0x8045, 0x8045, 0x8045, 0x8045, 0x8045,
+    0x8045, 0x8045, 0x8045, 0x8045, 0x8048, 0x8047, 0x8045, 0x8045, 0x8045, 0x8045, 0x8045,
+    0x8048, 0x8048, 0x8048, 0x8048, 0x8049, 0x804A, 0x8048, 0x8048, 0x8048, 0x8048, 0x8048,
+    0x8048, 0x8048, 0x8048, 0x8048, 0x8049, 0x8045, 0x8048, 0x8048, 0x8048, 0x8048, 0x8048,
+    0x8048, 0x8048, 0x8048, 0x8048, 0x8048, 0x804A, 0x8048, 0x8048, 0x8048, 0x8048, 0x8048,
+};
+
+uint8_t g_LexerRust_StateCategories[] = {
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_default,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default,
+    dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_default, dred_highlight_category_default,
+    dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_comment,
+    dred_highlight_category_comment, dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_string,
+    dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_comment,
+    dred_highlight_category_comment, dred_highlight_category_comment, dred_highlight_category_comment,
+};
+
+uint8_t g_LexerRust_StateFlags[] = {
+    0, 0, 2, 0, 0, 1, 1, 1, 0, 2, 0, 2, 2, 0, 0, 1, 1, 2, 0, 2, 2, 2, 0, 0, 2, 0, 0, 2, 0, 2, 0, 2,
+    2, 0, 2, 2, 2, 2, 0, 0, 2, 2, 2, 0, 2, 2, 2, 2, 2, 2, 2, 2, 0, 2, 2, 0, 2, 2, 2, 2, 2, 0, 2, 0,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+};
+
+const char* g_LanguageRust_Extensions[] = {"rs", NULL};
+
+dred_highlight_language g_LanguageRust = {"rust", g_LanguageRust_Extensions, 75, 11, g_LexerRust_CharClasses, g_LexerRust_Transitions, g_LexerRust_StateCategories, g_LexerRust_StateFlags, &g_KeywordTableRust};
+
+dred_highlight_keyword g_KeywordTableShell_Keywords[] = {
+    {"local", 5, dred_highlight_category_instruction},
+    {"elif", 4, dred_highlight_category_instruction},
+    {"do", 2, dred_highlight_category_instruction},
+    {"then", 4, dred_highlight_category_instruction},
+    {"for", 3, dred_highlight_category_instruction},
+    {"readonly", 8, dred_highlight_category_instruction},
+    {"else", 4, dred_highlight_category_instruction},
+    {"done", 4, dred_highlight_category_instruction},
+    {"unset", 5, dred_highlight_category_instruction},
+    {"break", 5, dred_highlight_category_instruction},
+    {"shift", 5, dred_highlight_category_instruction},
+    {"declare", 7, dred_highlight_category_instruction},
+    {"exit", 4, dred_highlight_category_instruction},
+    {"continue", 8, dred_highlight_category_instruction},
+    {"function", 8, dred_highlight_category_instruction},
+    {"if", 2, dred_highlight_category_instruction},
+    {"time", 4, dred_highlight_category_instruction},
+    {"export", 6, dred_highlight_category_instruction},
+    {"while", 5, dred_highlight_category_instruction},
+    {"select", 6, dred_highlight_category_instruction},
+    {"in", 2, dred_highlight_category_instruction},
+    {"esac", 4, dred_highlight_category_instruction},
+    {"return", 6, dred_highlight_category_instruction},
+    {"fi", 2, dred_highlight_category_instruction},
+    {"case", 4, dred_highlight_category_instruction},
+    {"source", 6, dred_highlight_category_instruction},
+    {"until", 5, dred_highlight_category_instruction},
+};
+
+uint16_t g_KeywordTableShell_Displacements[] = {
+    6, 0, 0, 0, 6, 79, 22, 2, 0, 1, 18, 0, 29, 1,
+};
+
+dred_highlight_keyword_table g_KeywordTableShell = {g_KeywordTableShell_Keywords, 27, g_KeywordTableShell_Displacements, 14};
+
+uint8_t g_LexerShell_CharClasses[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 0, 3, 4, 0, 0, 1, 5, 1, 1, 0, 0, 0, 0, 0, 0, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 0, 1, 1, 0, 1, 0,
+    0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 8, 0, 0, 7,
+    9, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+uint16_t g_LexerShell_Transitions[] = {
+    0x8001, 0x8002, 0x8002, 0x8003, 0x8004, 0x8005, 0x8001, 0x8006, 0x8001, 0x8007,
+    0x8008, 0x8009, 0x8009, 0xFFFF, 0x8008, 0xFFFF, 0x8008, 0xFFFF, 0x8008, 0xFFFF,
+    0x8008, 0x8009, 0x8009, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF,
+    0x800A, 0x800A, 0x800A, 0x800B, 0x800A, 0x800A, 0x800A, 0x800A, 0x800C, 0x800A,
+    0x800D, 0x800D, 0xFFFF, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x800E, 0x800F, 0x800E, 0x800E, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF, 0x8010, 0x8010, 0xFFFF, 0xFFFF,
+    0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8012, 0x8013,
+    0x8008, 0x8009, 0x8009, 0xFFFF, 0x8008, 0xFFFF, 0x8008, 0xFFFF, 0x8008, 0xFFFF,
+    0x8008, 0x8009, 0x8009, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF,
+    0x800A, 0x800A, 0x800A, 0x800B, 0x800A, 0x800A, 0x800A, 0x800A, 0x800C, 0x800A,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0x800A, 0x800A, 0x800A, 0x800A, 0x800A, 0x800A, 0x800A, 0x800A, 0x800A, 0x800A,
+    0x800D, 0x800D, 0xFFFF, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D, 0x800D,
+    0x800E, 0x800E, 0x800E, 0x800E, 0x800E, 0x800F, 0x800E, 0x800E, 0x800E, 0x800E,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x8008, 0xFFFF, 0x8010, 0x8010, 0xFFFF, 0xFFFF,
+    0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8012, 0x8013,
+    0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011, 0x8011,
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF,
+};
+
+uint8_t g_LexerShell_StateCategories[] = {
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string,
+    dred_highlight_category_comment, dred_highlight_category_string, dred_highlight_category_default, dred_highlight_category_string,
+    dred_highlight_category_default, dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_string, dred_highlight_category_comment, dred_highlight_category_string, dred_highlight_category_string,
+    dred_highlight_category_default, dred_highlight_category_string, dred_highlight_category_string, dred_highlight_category_string,
+};
+
+uint8_t g_LexerShell_StateFlags[] = {
+    0, 0, 0, 2, 0, 2, 1, 2, 0, 0, 2, 0, 2, 0, 2, 0, 1, 2, 2, 0,
+};
+
+const char* g_LanguageShell_Extensions[] = {"sh", "bash", NULL};
+
+dred_highlight_language g_LanguageShell = {"shell", g_LanguageShell_Extensions, 20, 10, g_LexerShell_CharClasses, g_LexerShell_Transitions, g_LexerShell_StateCategories, g_LexerShell_StateFlags, &g_KeywordTableShell};
+
+#define DRED_LANGUAGE_COUNT 5
+
+dred_highlight_language* g_Languages[DRED_LANGUAGE_COUNT] = {
+    &g_LanguageC,
+    &g_LanguageCpp,
+    &g_LanguagePython,
+    &g_LanguageRust,
+    &g_LanguageShell,
+};
@@ -59,6 +59,8 @@
 #define DRED_MAX_RECENT_FILES       10
 #define DRED_MAX_RECENT_COMMANDS    32
 
+#define DRED_MAX_PAINTS_PER_SECOND  60
+
 
 // Define these to exclude certain features from the build.
 
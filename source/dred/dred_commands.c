@@ -583,11 +583,124 @@ dr_bool32 dred_command__replace_all(dred_context* pDred, const char* value)
             char replacement[1024];
             value = dr_next_token(value, replacement, sizeof(replacement));
             if (value != NULL) {
-                if (!dred_text_editor_find_and_replace_all(DRED_TEXT_EDITOR(pFocusedEditor), query, replacement)) {
+                size_t replacementCount = dred_text_editor_find_and_replace_all(DRED_TEXT_EDITOR(pFocusedEditor), query, replacement);
+                if (replacementCount == 0) {
                     dred_cmdbar_set_message(pDred->pCmdBar, "No results found.");
                     return DR_FALSE;
                 }
 
+                char msg[64];
+                snprintf(msg, sizeof(msg), "Replaced %u occurrence%s.", (unsigned int)replacementCount, (replacementCount == 1) ? "" : "s");
+                dred_cmdbar_set_message(pDred->pCmdBar, msg);
+
+                return DR_TRUE;
+            }
+        }
+    }
+
+    return DR_FALSE;
+}
+
+dr_bool32 dred_command__find_regex(dred_context* pDred, const char* value)
+{
+    dred_editor* pFocusedEditor = dred_get_focused_editor(pDred);
+    if (pFocusedEditor == NULL) {
+        return DR_FALSE;
+    }
+
+    if (dred_control_is_of_type(DRED_CONTROL(pFocusedEditor), DRED_CONTROL_TYPE_TEXT_EDITOR)) {
+        char query[1024];
+        if (dr_next_token(value, query, sizeof(query)) != NULL) {
+            drte_regex* pRegex = drte_regex_create(query, 0);
+            if (pRegex == NULL) {
+                dred_cmdbar_set_message(pDred->pCmdBar, "Invalid regular expression.");
+                return DR_FALSE;
+            }
+
+            dred_text_editor_deselect_all_in_focused_view(DRED_TEXT_EDITOR(pFocusedEditor));
+            dr_bool32 result = dred_text_editor_find_regex_and_select_next(DRED_TEXT_EDITOR(pFocusedEditor), pRegex);
+            drte_regex_delete(pRegex);
+
+            if (!result) {
+                dred_cmdbar_set_message(pDred->pCmdBar, "No results found.");
+                return DR_FALSE;
+            }
+
+            return DR_TRUE;
+        }
+    }
+
+    return DR_FALSE;
+}
+
+dr_bool32 dred_command__replace_regex(dred_context* pDred, const char* value)
+{
+    dred_editor* pFocusedEditor = dred_get_focused_editor(pDred);
+    if (pFocusedEditor == NULL) {
+        return DR_FALSE;
+    }
+
+    if (dred_control_is_of_type(DRED_CONTROL(pFocusedEditor), DRED_CONTROL_TYPE_TEXT_EDITOR)) {
+        char query[1024];
+        value = dr_next_token(value, query, sizeof(query));
+        if (value != NULL) {
+            char replacement[1024];
+            value = dr_next_token(value, replacement, sizeof(replacement));
+            if (value != NULL) {
+                drte_regex* pRegex = drte_regex_create(query, 0);
+                if (pRegex == NULL) {
+                    dred_cmdbar_set_message(pDred->pCmdBar, "Invalid regular expression.");
+                    return DR_FALSE;
+                }
+
+                dr_bool32 result = dred_text_editor_find_regex_and_replace_next(DRED_TEXT_EDITOR(pFocusedEditor), pRegex, replacement);
+                drte_regex_delete(pRegex);
+
+                if (!result) {
+                    dred_cmdbar_set_message(pDred->pCmdBar, "No results found.");
+                    return DR_FALSE;
+                }
+
+                return DR_TRUE;
+            }
+        }
+    }
+
+    return DR_FALSE;
+}
+
+dr_bool32 dred_command__replace_all_regex(dred_context* pDred, const char* value)
+{
+    dred_editor* pFocusedEditor = dred_get_focused_editor(pDred);
+    if (pFocusedEditor == NULL) {
+        return DR_FALSE;
+    }
+
+    if (dred_control_is_of_type(DRED_CONTROL(pFocusedEditor), DRED_CONTROL_TYPE_TEXT_EDITOR)) {
+        char query[1024];
+        value = dr_next_token(value, query, sizeof(query));
+        if (value != NULL) {
+            char replacement[1024];
+            value = dr_next_token(value, replacement, sizeof(replacement));
+            if (value != NULL) {
+                drte_regex* pRegex = drte_regex_create(query, 0);
+                if (pRegex == NULL) {
+                    dred_cmdbar_set_message(pDred->pCmdBar, "Invalid regular expression.");
+                    return DR_FALSE;
+                }
+
+                size_t replacementCount = dred_text_editor_find_regex_and_replace_all(DRED_TEXT_EDITOR(pFocusedEditor), pRegex, replacement);
+                drte_regex_delete(pRegex);
+
+                if (replacementCount == 0) {
+                    dred_cmdbar_set_message(pDred->pCmdBar, "No results found.");
+                    return DR_FALSE;
+                }
+
+                char msg[64];
+                snprintf(msg, sizeof(msg), "Replaced %u occurrence%s.", (unsigned int)replacementCount, (replacementCount == 1) ? "" : "s");
+                dred_cmdbar_set_message(pDred->pCmdBar, msg);
+
                 return DR_TRUE;
             }
         }
@@ -1845,7 +1845,7 @@ void dred__init_print_font(dred_print_data* pPrintData)
     dr2d_font_metrics fontMetrics;
     dr2d_get_font_metrics(pPrintData->pFont, &fontMetrics);
 
-    drte_engine_register_style_token(&pPrintData->textEngine, (drte_style_token)pPrintData->pFont, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(&pPrintData->textEngine, (drte_style_token)pPrintData->pFont, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
     drte_engine_set_default_style(&pPrintData->textEngine, (drte_style_token)pPrintData->pFont);
 
 
@@ -2694,10 +2694,9 @@ const char* dred_get_language_by_file_path(dred_context* pDred, const char* file
 {
     (void)pDred;
 
-    // TODO: Use a map for this to make this easier to maintain. Also consider auto-generating default mappings.
-
-    if (drpath_extension_equal(filePath, "c") || drpath_extension_equal(filePath, "h")) {
-        return "c";
+    const dred_highlight_language* pLanguage = dred_find_highlight_language_by_file_path(filePath);
+    if (pLanguage != NULL) {
+        return pLanguage->name;
     }
 
     return "";
@@ -6,110 +6,731 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-// The generic highlighter is controlled based on basic properties. It does not do any language specific features, however it should have
-// enough properties that it can be used for many languages.
+// There is no language specific code in here. Each language is described by a definition file in resources/languages which dred_build
+// compiles into a DFA, and every language is lexed by the same loop over its transition table. See resources/languages/c.txt for the
+// definition format.
 
-dr_bool32 dred_highlighter__get_block_comment_of_character(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+uint64_t dred_highlighter__hash(const char* text, size_t length)
+{
+    // FNV-1a. This needs to match between the highlighting thread and the UI thread, and dred_build hashes keywords with it as well.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Retrieves the slot in a keyword table of a word with the given hash. This is the only slot the word can be in if it's a keyword at
+// all. dred_build uses a copy of this to build the tables so the two must always match.
+size_t dred_highlighter__get_keyword_slot(const dred_highlight_keyword_table* pTable, uint64_t hash)
+{
+    assert(pTable != NULL);
+    assert(pTable->keywordCount > 0);
+
+    uint32_t x = (uint32_t)hash ^ pTable->pDisplacements[(uint32_t)(hash >> 32) % pTable->bucketCount];
+
+    // The MurmurHash3 finalizer. The displacement needs to be mixed in properly or keywords that collide will keep colliding.
+    x ^= x >> 16;
+    x *= 0x85EBCA6B;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35;
+    x ^= x >> 16;
+
+    return x % pTable->keywordCount;
+}
+
+dr_bool32 dred_highlighter__find_keyword(const dred_highlight_keyword_table* pTable, const char* text, size_t length, dred_highlight_category* pCategoryOut)
+{
+    assert(pCategoryOut != NULL);
+
+    if (pTable == NULL || pTable->keywordCount == 0) {
+        return DR_FALSE;
+    }
+
+    const dred_highlight_keyword* pKeyword = &pTable->pKeywords[dred_highlighter__get_keyword_slot(pTable, dred_highlighter__hash(text, length))];
+    if (pKeyword->length != length || memcmp(pKeyword->keyword, text, length) != 0) {
+        return DR_FALSE;
+    }
+
+    *pCategoryOut = pKeyword->category;
+    return DR_TRUE;
+}
+
+dr_bool32 dred_highlighter__add_span(dred_highlight_result* pResult, size_t iCharBeg, size_t iCharEnd, dred_highlight_category category)
+{
+    assert(pResult != NULL);
+
+    if (pResult->spanCount == pResult->spanCapacity) {
+        size_t newCapacity = (pResult->spanCapacity == 0) ? 256 : pResult->spanCapacity*2;
+        dred_highlight_span* pNewSpans = (dred_highlight_span*)realloc(pResult->pSpans, newCapacity * sizeof(*pNewSpans));
+        if (pNewSpans == NULL) {
+            return DR_FALSE;
+        }
+
+        pResult->pSpans = pNewSpans;
+        pResult->spanCapacity = newCapacity;
+    }
+
+    pResult->pSpans[pResult->spanCount].iCharBeg = iCharBeg;
+    pResult->pSpans[pResult->spanCount].iCharEnd = iCharEnd;
+    pResult->pSpans[pResult->spanCount].category = category;
+    pResult->spanCount += 1;
+    return DR_TRUE;
+}
+
+// Adds the span of a token that ended in the given state, unless it's not highlighted.
+void dred_highlighter__add_token(const dred_highlight_language* pLanguage, const char* text, size_t iTokenBeg, size_t iTokenEnd, uint32_t state, dred_highlight_result* pResult)
+{
+    assert(pLanguage != NULL);
+
+    if (iTokenBeg == iTokenEnd) {
+        return;
+    }
+
+    dred_highlight_category category = (dred_highlight_category)pLanguage->pStateCategories[state];
+    if (pLanguage->pStateFlags[state] & DRED_LEXER_STATE_IDENTIFIER) {
+        dred_highlighter__find_keyword(pLanguage->pKeywords, text + iTokenBeg, iTokenEnd - iTokenBeg, &category);
+    }
+
+    if (category != dred_highlight_category_default) {
+        dred_highlighter__add_span(pResult, iTokenBeg, iTokenEnd, category);
+    }
+}
+
+// Lexes a single line, starting in the given state, and returns the state the next line starts in. The spans are added to the given
+// result relative to the start of the line.
+//
+// This is run on the highlighting thread. The language never changes after the highlighter is initialized so it's safe to read it
+// from here, but nothing else in the highlighter should be touched.
+uint32_t dred_highlighter__lex_line(const dred_highlight_language* pLanguage, const char* text, size_t length, uint32_t state, dred_highlight_result* pResult)
+{
+    assert(pLanguage != NULL);
+    assert(pResult != NULL);
+
+    const uint8_t* pCharClasses = pLanguage->pCharClasses;
+    const uint16_t* pTransitions = pLanguage->pTransitions;
+    const uint8_t* pStateCategories = pLanguage->pStateCategories;
+    const uint8_t* pStateFlags = pLanguage->pStateFlags;
+    size_t classCount = pLanguage->classCount;
+
+    // A line that starts inside something like a block comment has already matched a token, albeit an empty one.
+    size_t iTokenBeg = 0;
+    size_t iTokenEnd = 0;
+    uint32_t acceptState = (pStateFlags[state] & DRED_LEXER_STATE_CONTINUES) ? state : DRED_LEXER_DEAD_STATE;
+
+    size_t i = 0;
+    for (;;) {
+        while (i < length) {
+            uint32_t next = pTransitions[state*classCount + pCharClasses[(unsigned char)text[i]]];
+            if (next == DRED_LEXER_DEAD_STATE) {
+                break;
+            }
+
+            state = next & ~DRED_LEXER_ACCEPT_BIT;
+            i += 1;
+
+            // Most characters leave the lexer in the state it's already in, such as those in the middle of a comment or identifier.
+            // Runs of them are skipped in a tighter loop that doesn't have to wait on the state from the previous character.
+            const uint16_t* pRow = &pTransitions[state*classCount];
+            while (i < length && pRow[pCharClasses[(unsigned char)text[i]]] == next) {
+                i += 1;
+            }
+
+            if (next & DRED_LEXER_ACCEPT_BIT) {
+                acceptState = state;
+                iTokenEnd = i;
+            }
+        }
+
+        // Anything that carries on to the next line, such as a block comment, goes to the end of this one.
+        if (i == length && (pStateFlags[state] & DRED_LEXER_STATE_CONTINUES)) {
+            dred_highlighter__add_token(pLanguage, text, iTokenBeg, length, state, pResult);
+            return state;
+        }
+
+        // Otherwise the token is the longest one that was matched and lexing starts again straight after it. Every character can be
+        // a token by itself so this always moves forward, unless the line started with an empty token. Most tokens are white space
+        // or punctuation, so they are filtered out here rather than paying for a call.
+        if (acceptState != DRED_LEXER_DEAD_STATE && (pStateCategories[acceptState] != dred_highlight_category_default || pStateFlags[acceptState] != 0)) {
+            dred_highlighter__add_token(pLanguage, text, iTokenBeg, iTokenEnd, acceptState, pResult);
+        }
+
+        if (iTokenEnd >= length) {
+            return DRED_HIGHLIGHT_STATE_DEFAULT;
+        }
+
+        i = iTokenBeg = iTokenEnd;
+        state = DRED_HIGHLIGHT_STATE_DEFAULT;
+        acceptState = DRED_LEXER_DEAD_STATE;
+    }
+}
+
+
+//// Highlighting Thread ////
+
+void dred_highlighter__delete_job(dred_highlight_job* pJob)
+{
+    if (pJob == NULL) {
+        return;
+    }
+
+    free(pJob->pStates);
+    free(pJob->pIsDirty);
+    free(pJob->pText);
+    free(pJob);
+}
+
+void dred_highlighter__delete_result(dred_highlight_result* pResult)
+{
+    if (pResult == NULL) {
+        return;
+    }
+
+    free(pResult->pStates);
+    free(pResult->pLexedLines);
+    free(pResult->pSpans);
+    free(pResult);
+}
+
+dr_bool32 dred_highlighter__add_result_line(dred_highlight_result* pResult, dred_highlight_result_line* pLine)
+{
+    assert(pResult != NULL);
+    assert(pLine != NULL);
+
+    if (pResult->lexedLineCount == pResult->lexedLineCapacity) {
+        size_t newCapacity = (pResult->lexedLineCapacity == 0) ? 64 : pResult->lexedLineCapacity*2;
+        dred_highlight_result_line* pNewLines = (dred_highlight_result_line*)realloc(pResult->pLexedLines, newCapacity * sizeof(*pNewLines));
+        if (pNewLines == NULL) {
+            return DR_FALSE;
+        }
+
+        pResult->pLexedLines = pNewLines;
+        pResult->lexedLineCapacity = newCapacity;
+    }
+
+    pResult->pLexedLines[pResult->lexedLineCount] = *pLine;
+    pResult->lexedLineCount += 1;
+    return DR_TRUE;
+}
+
+// Lexes the lines of a job that need it. A line is skipped if it was up to date when the job was made and the line before it ended in
+// the state it was already known to start in. Returns NULL if we run out of memory.
+dred_highlight_result* dred_highlighter__run_job(dred_highlighter* pHighlighter, dred_highlight_job* pJob)
+{
+    assert(pHighlighter != NULL);
+    assert(pJob != NULL);
+
+    dred_highlight_result* pResult = (dred_highlight_result*)calloc(1, sizeof(*pResult));
+    if (pResult == NULL) {
+        return NULL;
+    }
+
+    pResult->textVersion = pJob->textVersion;
+    pResult->iFirstLine = pJob->iFirstLine;
+    pResult->lineCount = pJob->lineCount;
+    pResult->pStates = (uint32_t*)malloc(pJob->lineCount * sizeof(*pResult->pStates));
+    if (pResult->pStates == NULL) {
+        dred_highlighter__delete_result(pResult);
+        return NULL;
+    }
+
+    size_t iLineCharBeg = 0;
+    uint32_t state = pJob->pStates[0];
+    for (size_t iLine = 0; iLine < pJob->lineCount; ++iLine) {
+        size_t iLineCharEnd = iLineCharBeg;
+        while (iLineCharEnd < pJob->textLength && pJob->pText[iLineCharEnd] != '\n') {
+            iLineCharEnd += 1;
+        }
+        if (iLineCharEnd < pJob->textLength) {
+            iLineCharEnd += 1;  // <-- Include the new line character.
+        }
+
+        pResult->pStates[iLine] = state;
+        pResult->isLastLineLexed = pJob->pIsDirty[iLine] || pJob->pStates[iLine] != state;
+
+        if (pResult->isLastLineLexed) {
+            dred_highlight_result_line line;
+            line.iLine = pJob->iFirstLine + iLine;
+            line.hash = dred_highlighter__hash(pJob->pText + iLineCharBeg, iLineCharEnd - iLineCharBeg);
+            line.length = iLineCharEnd - iLineCharBeg;
+            line.state = state;
+            line.iFirstSpan = pResult->spanCount;
+            state = dred_highlighter__lex_line(pHighlighter->pLanguage, pJob->pText + iLineCharBeg, iLineCharEnd - iLineCharBeg, state, pResult);
+            line.spanCount = pResult->spanCount - line.iFirstSpan;
+            if (!dred_highlighter__add_result_line(pResult, &line)) {
+                dred_highlighter__delete_result(pResult);
+                return NULL;
+            }
+
+            pResult->nextState = state;
+        } else {
+            // The line was already up to date, so the next line starts in the state it was already known to start in.
+            if (iLine+1 < pJob->lineCount) {
+                state = pJob->pStates[iLine+1];
+            }
+        }
+
+        iLineCharBeg = iLineCharEnd;
+
+        // There's no point carrying on if the text has already changed since the result will just be thrown away.
+        if ((iLine & 1023) == 1023) {
+            dred_mutex_lock(&pHighlighter->worker.lock);
+            dr_bool32 isStale = pHighlighter->worker.latestTextVersion != pJob->textVersion;
+            dred_mutex_unlock(&pHighlighter->worker.lock);
+
+            if (isStale) {
+                break;
+            }
+        }
+    }
+
+    return pResult;
+}
+
+dred_thread_result DRED_THREADCALL dred_highlighter__thread_proc(void* pData)
+{
+    dred_highlighter* pHighlighter = (dred_highlighter*)pData;
+    assert(pHighlighter != NULL);
+
+    for (;;) {
+        dred_semaphore_wait(&pHighlighter->worker.wakeup);
+
+        dred_mutex_lock(&pHighlighter->worker.lock);
+        dr_bool32 isTerminating = pHighlighter->worker.isTerminating;
+        dred_highlight_job* pJob = pHighlighter->worker.pJob;
+        pHighlighter->worker.pJob = NULL;
+        dred_mutex_unlock(&pHighlighter->worker.lock);
+
+        if (isTerminating) {
+            dred_highlighter__delete_job(pJob);
+            break;
+        }
+
+        if (pJob == NULL) {
+            continue;
+        }
+
+        // A result is always posted, even if it's empty, so the UI thread knows the job is finished.
+        dred_highlight_result* pResult = dred_highlighter__run_job(pHighlighter, pJob);
+        if (pResult == NULL) {
+            pResult = (dred_highlight_result*)calloc(1, sizeof(*pResult));
+        }
+        if (pResult != NULL) {
+            pResult->textVersion = pJob->textVersion;
+        }
+
+        dred_highlighter__delete_job(pJob);
+
+        dred_mutex_lock(&pHighlighter->worker.lock);
+        dred_highlighter__delete_result(pHighlighter->worker.pResult);
+        pHighlighter->worker.pResult = pResult;
+        dred_mutex_unlock(&pHighlighter->worker.lock);
+    }
+
+    return 0;
+}
+
+
+//// UI Thread ////
+
+dred_highlight_line* dred_highlighter__find_line(dred_highlighter* pHighlighter, uint64_t hash, size_t length, uint32_t state)
+{
+    assert(pHighlighter != NULL);
+
+    dred_highlight_line* pSet = pHighlighter->pLines + ((size_t)(hash ^ (hash >> 32)) & (DRED_HIGHLIGHT_CACHE_SET_COUNT-1))*DRED_HIGHLIGHT_CACHE_WAY_COUNT;
+    for (size_t iWay = 0; iWay < DRED_HIGHLIGHT_CACHE_WAY_COUNT; ++iWay) {
+        dred_highlight_line* pLine = pSet + iWay;
+        if (pLine->lastUsed != 0 && pLine->hash == hash && pLine->length == length && pLine->state == state) {
+            pLine->lastUsed = ++pHighlighter->clock;
+            return pLine;
+        }
+    }
+
+    return NULL;
+}
+
+dr_bool32 dred_highlighter__store_line(dred_highlighter* pHighlighter, dred_highlight_result* pResult, dred_highlight_result_line* pResultLine)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
+    assert(pResult != NULL);
+    assert(pResultLine != NULL);
+
+    dred_highlight_line* pLine = dred_highlighter__find_line(pHighlighter, pResultLine->hash, pResultLine->length, pResultLine->state);
+    if (pLine == NULL) {
+        dred_highlight_line* pSet = pHighlighter->pLines + ((size_t)(pResultLine->hash ^ (pResultLine->hash >> 32)) & (DRED_HIGHLIGHT_CACHE_SET_COUNT-1))*DRED_HIGHLIGHT_CACHE_WAY_COUNT;
+
+        pLine = pSet;
+        for (size_t iWay = 1; iWay < DRED_HIGHLIGHT_CACHE_WAY_COUNT; ++iWay) {
+            if (pSet[iWay].lastUsed < pLine->lastUsed) {
+                pLine = pSet + iWay;
+            }
+        }
+
+        if (pLine->spanCapacity < pResultLine->spanCount) {
+            dred_highlight_span* pNewSpans = (dred_highlight_span*)realloc(pLine->pSpans, pResultLine->spanCount * sizeof(*pNewSpans));
+            if (pNewSpans == NULL) {
+                return DR_FALSE;
+            }
+
+            pLine->pSpans = pNewSpans;
+            pLine->spanCapacity = pResultLine->spanCount;
+        }
+
+        pLine->hash = pResultLine->hash;
+        pLine->length = pResultLine->length;
+        pLine->state = pResultLine->state;
+        pLine->lastUsed = ++pHighlighter->clock;
+        pLine->spanCount = pResultLine->spanCount;
+        if (pResultLine->spanCount > 0) {
+            memcpy(pLine->pSpans, pResult->pSpans + pResultLine->iFirstSpan, pResultLine->spanCount * sizeof(*pLine->pSpans));
+        }
+    }
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    return DR_TRUE;
 }
 
-dr_bool32 dred_highlighter__get_line_comment_of_character(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+// Stores the lines of a result in the cache and brings the states in the line cache up to date. This assumes the text has not changed
+// since the job was made.
+void dred_highlighter__apply_result(dred_highlighter* pHighlighter, dred_highlight_result* pResult)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
+    assert(pResult != NULL);
+
+    drte_line_cache* pLineCache = pHighlighter->pEngine->pUnwrappedLines;
+    if (pResult->lineCount == 0) {
+        return;
+    }
+
+    drte_line_cache_set_line_highlight_states(pLineCache, pResult->iFirstLine, pResult->lineCount, pResult->pStates);
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    size_t iNextLine = pResult->iFirstLine + pResult->lineCount;
+    if (pResult->isLastLineLexed && iNextLine < drte_line_cache_get_line_count(pLineCache)) {
+        if (drte_line_cache_is_line_highlight_dirty(pLineCache, iNextLine) || drte_line_cache_get_line_highlight_state(pLineCache, iNextLine) != pResult->nextState) {
+            drte_line_cache_set_line_highlight_state(pLineCache, iNextLine, pResult->nextState, DR_TRUE);
+        }
+    }
+
+    // The job ends at the line that was requested, so the lines that are being looked at are at the end. Lines further up were only
+    // lexed to find out which state the lines below them start in. Storing them would just push the visible lines out of the cache.
+    // If any of them end up being painted they'll be highlighted again by themselves.
+    size_t maxStoredLineCount = (DRED_HIGHLIGHT_CACHE_SET_COUNT*DRED_HIGHLIGHT_CACHE_WAY_COUNT) / 4;
+    size_t iFirstStoredLine = 0;
+    if (pResult->lineCount > maxStoredLineCount) {
+        iFirstStoredLine = pResult->iFirstLine + pResult->lineCount - maxStoredLineCount;
+    }
+
+    for (size_t i = 0; i < pResult->lexedLineCount; ++i) {
+        if (pResult->pLexedLines[i].iLine >= iFirstStoredLine) {
+            dred_highlighter__store_line(pHighlighter, pResult, &pResult->pLexedLines[i]);
+        }
+    }
+
+    // The spans the engine is holding on to may be out of date.
+    drte_engine_invalidate_highlights(pHighlighter->pEngine);
 }
 
-dr_bool32 dred_highlighter__get_comment_of_character(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+// Hands a job over to the highlighting thread covering every dirty line up to the line that was most recently requested. Returns
+// DR_FALSE if there is nothing to do.
+dr_bool32 dred_highlighter__post_job(dred_highlighter* pHighlighter)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
+    assert(!pHighlighter->worker.isJobInProgress);
+
+    drte_engine* pEngine = pHighlighter->pEngine;
+    drte_line_cache* pLineCache = pEngine->pUnwrappedLines;
+    size_t lineCount = drte_line_cache_get_line_count(pLineCache);
+
+    size_t iFirstLine;
+    if (!drte_line_cache_find_highlight_dirty_line(pLineCache, &iFirstLine) || iFirstLine > pHighlighter->iRequestedLine) {
+        return DR_FALSE;
+    }
+
+    size_t iLastLine = dr_min(pHighlighter->iRequestedLine, lineCount-1);
+
+    dred_highlight_job* pJob = (dred_highlight_job*)calloc(1, sizeof(*pJob));
+    if (pJob == NULL) {
+        return DR_FALSE;
+    }
+
+    size_t iTextBeg = drte_line_cache_get_line_first_character(pLineCache, iFirstLine);
+    size_t iTextEnd = (iLastLine+1 < lineCount) ? drte_line_cache_get_line_first_character(pLineCache, iLastLine+1) : pEngine->textLength;
+
+    pJob->textVersion = drte_engine_get_text_version(pEngine);
+    pJob->iFirstLine = iFirstLine;
+    pJob->lineCount = iLastLine - iFirstLine + 1;
+    pJob->textLength = iTextEnd - iTextBeg;
+    pJob->pStates = (uint32_t*)malloc(pJob->lineCount * sizeof(*pJob->pStates));
+    pJob->pIsDirty = (dr_bool32*)malloc(pJob->lineCount * sizeof(*pJob->pIsDirty));
+    pJob->pText = (char*)malloc(pJob->textLength + 1);
+    if (pJob->pStates == NULL || pJob->pIsDirty == NULL || pJob->pText == NULL) {
+        dred_highlighter__delete_job(pJob);
+        return DR_FALSE;
+    }
+
+    drte_line_cache_get_line_highlight_states(pLineCache, iFirstLine, pJob->lineCount, pJob->pStates, pJob->pIsDirty);
+    drte_piece_table_copy(&pEngine->_text, iTextBeg, iTextEnd, pJob->pText);
+    pJob->pText[pJob->textLength] = '\0';
+
+    dred_mutex_lock(&pHighlighter->worker.lock);
+    pHighlighter->worker.latestTextVersion = pJob->textVersion;
+    pHighlighter->worker.pJob = pJob;
+    dred_mutex_unlock(&pHighlighter->worker.lock);
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    dred_semaphore_release(&pHighlighter->worker.wakeup);
+
+    pHighlighter->worker.isJobInProgress = DR_TRUE;
+    return DR_TRUE;
 }
 
+void dred_highlighter__on_timer(dred_timer* pTimer, void* pUserData)
+{
+    (void)pTimer;
+
+    dred_highlighter* pHighlighter = (dred_highlighter*)pUserData;
+    assert(pHighlighter != NULL);
+
+    uint64_t textVersion = drte_engine_get_text_version(pHighlighter->pEngine);
+
+    dred_mutex_lock(&pHighlighter->worker.lock);
+    dred_highlight_result* pResult = pHighlighter->worker.pResult;
+    pHighlighter->worker.pResult = NULL;
+    pHighlighter->worker.latestTextVersion = textVersion;   // <-- Lets the highlighting thread give up early on a stale job.
+    dred_mutex_unlock(&pHighlighter->worker.lock);
+
+    if (pResult != NULL) {
+        pHighlighter->worker.isJobInProgress = DR_FALSE;
 
+        // If the text has changed the line indices in the result could be wrong so it needs to be thrown away. Anything that was
+        // edited will have been painted again and requested a new job.
+        if (pResult->textVersion == textVersion) {
+            dred_highlighter__apply_result(pHighlighter, pResult);
+        }
 
-dr_bool32 dred_highlighter__get_next_block_comment_on_line(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+        dred_highlighter__delete_result(pResult);
+    }
+
+    if (!pHighlighter->worker.isJobInProgress && pHighlighter->hasRequest) {
+        dred_highlighter__post_job(pHighlighter);
+        pHighlighter->hasRequest = DR_FALSE;
+    }
+
+    // The timer is deleted from inside its own callback which is fine because nothing touches it after this returns.
+    if (!pHighlighter->worker.isJobInProgress && !pHighlighter->hasRequest) {
+        dred_timer_delete(pHighlighter->pTimer);
+        pHighlighter->pTimer = NULL;
+    }
+}
+
+void dred_highlighter__request_line(dred_highlighter* pHighlighter, size_t iLine)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    if (!pHighlighter->hasRequest || pHighlighter->iRequestedLine < iLine) {
+        pHighlighter->iRequestedLine = iLine;
+    }
+
+    pHighlighter->hasRequest = DR_TRUE;
+
+    if (pHighlighter->pTimer == NULL) {
+        pHighlighter->pTimer = dred_timer_create(DRED_HIGHLIGHT_TIMER_INTERVAL, dred_highlighter__on_timer, pHighlighter);
+    }
 }
 
-dr_bool32 dred_highlighter__get_next_line_comment_on_line(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+// Retrieves the cached highlighting of the given line, or NULL if it hasn't been highlighted yet. If the line needs to be highlighted
+// it'll be requested from the highlighting thread.
+dred_highlight_line* dred_highlighter__get_line(dred_highlighter* pHighlighter, size_t iLine, size_t* pLineCharBegOut)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
+    assert(pLineCharBegOut != NULL);
+
+    drte_engine* pEngine = pHighlighter->pEngine;
+    drte_line_cache* pLineCache = pEngine->pUnwrappedLines;
+
+    size_t iLineCharBeg = drte_line_cache_get_line_first_character(pLineCache, iLine);
+    size_t iLineCharEnd = (iLine+1 < drte_line_cache_get_line_count(pLineCache)) ? drte_line_cache_get_line_first_character(pLineCache, iLine+1) : pEngine->textLength;
+
+    *pLineCharBegOut = iLineCharBeg;
+
+    uint64_t hash = dred_highlighter__hash(drte_piece_table_get_string(&pEngine->_text, iLineCharBeg, iLineCharEnd), iLineCharEnd - iLineCharBeg);
+    uint32_t state = drte_line_cache_get_line_highlight_state(pLineCache, iLine);
+
+    // A line that is up to date but has since been pushed out of the cache needs to be highlighted again.
+    dred_highlight_line* pLine = dred_highlighter__find_line(pHighlighter, hash, iLineCharEnd - iLineCharBeg, state);
+    if (pLine == NULL && !drte_line_cache_is_line_highlight_dirty(pLineCache, iLine)) {
+        drte_line_cache_invalidate_line_highlight_state(pLineCache, iLine);
+    }
+
+    // If anything above the line is dirty the state the line starts in may be out of date. It's still drawn the way it was in the
+    // meantime, which is correct for the state it's currently thought to start in.
+    size_t iFirstDirtyLine;
+    if (drte_line_cache_find_highlight_dirty_line(pLineCache, &iFirstDirtyLine) && iFirstDirtyLine <= iLine) {
+        dred_highlighter__request_line(pHighlighter, iLine);
+    }
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    return pLine;
 }
 
-dr_bool32 dred_highlighter__get_next_comment_on_line(dred_highlighter* pHighlighter, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut)
+drte_style_token dred_highlighter__get_style_token(dred_highlighter* pHighlighter, dred_highlight_category category)
 {
     assert(pHighlighter != NULL);
-    assert(pCharBegOut != NULL);
-    assert(pCharEndOut != NULL);
 
-    (void)pHighlighter;
-    (void)iChar;
-    (void)pCharBegOut;
-    (void)pCharEndOut;
-    return DR_FALSE;
+    switch (category)
+    {
+        case dred_highlight_category_comment: return (drte_style_token)&pHighlighter->styles.common.comment;
+        case dred_highlight_category_string:  return (drte_style_token)&pHighlighter->styles.common.string;
+        default: return (drte_style_token)&pHighlighter->styles.common.keyword;
+    }
 }
 
 
-dr_bool32 dred_highlighter__on_get_next_highlight(drte_engine* pEngine, size_t iChar, size_t* pCharBegOut, size_t* pCharEndOut, drte_style_token* pStyleTokenOut, void* pUserData)
+size_t dred_highlighter__on_get_highlights(drte_engine* pEngine, size_t iLineBeg, size_t iLineEnd, drte_highlight_span* pSpansOut, size_t spanCapacity, void* pUserData)
 {
-    if (pEngine == NULL || pCharBegOut == NULL || pCharEndOut == NULL || pStyleTokenOut == NULL || pUserData == NULL) {
-        return DR_FALSE;
+    if (pEngine == NULL || pUserData == NULL) {
+        return 0;
+    }
+
+    dred_highlighter* pHighlighter = (dred_highlighter*)pUserData;
+    assert(pHighlighter->pEngine == pEngine);
+
+    // Every span is counted, but only the ones that fit are written. The engine will make room for the rest and ask again.
+    size_t spanCount = 0;
+    for (size_t iLine = iLineBeg; iLine < iLineEnd; ++iLine) {
+        // Lines that haven't been highlighted yet are drawn with the default style.
+        size_t iLineCharBeg;
+        dred_highlight_line* pLine = dred_highlighter__get_line(pHighlighter, iLine, &iLineCharBeg);
+        if (pLine == NULL) {
+            continue;
+        }
+
+        for (size_t iSpan = 0; iSpan < pLine->spanCount; ++iSpan) {
+            if (spanCount < spanCapacity) {
+                pSpansOut[spanCount].iCharBeg = iLineCharBeg + pLine->pSpans[iSpan].iCharBeg;
+                pSpansOut[spanCount].iCharEnd = iLineCharBeg + pLine->pSpans[iSpan].iCharEnd;
+                pSpansOut[spanCount].styleToken = dred_highlighter__get_style_token(pHighlighter, pLine->pSpans[iSpan].category);
+            }
+
+            spanCount += 1;
+        }
     }
 
-    (void)iChar;
-    return DR_FALSE;
+    return spanCount;
 }
 
 
-dr_bool32 dred_highlighter_init(dred_highlighter* pHighlighter, dred_context* pDred, drte_engine* pEngine, dred_highlight_keyword* keywords, size_t keywordCount)
+dr_bool32 dred_highlighter_init(dred_highlighter* pHighlighter, dred_context* pDred, drte_engine* pEngine, const dred_highlight_language* pLanguage)
 {
-    if (pHighlighter == NULL) {
+    if (pHighlighter == NULL || pEngine == NULL) {
         return DR_FALSE;
     }
 
-    (void)pDred;
-    (void)pEngine;
-    (void)keywords;
-    (void)keywordCount;
-    return DR_FALSE;
+    pHighlighter->pDred = pDred;
+    pHighlighter->pEngine = pEngine;
+    pHighlighter->onGetHighlights = dred_highlighter__on_get_highlights;
+    pHighlighter->pLanguage = pLanguage;
+    pHighlighter->clock = 0;
+    pHighlighter->hasRequest = DR_FALSE;
+    pHighlighter->pTimer = NULL;
+    memset(&pHighlighter->worker, 0, sizeof(pHighlighter->worker));
+
+    pHighlighter->pLines = (dred_highlight_line*)calloc(DRED_HIGHLIGHT_CACHE_SET_COUNT*DRED_HIGHLIGHT_CACHE_WAY_COUNT, sizeof(*pHighlighter->pLines));
+    if (pHighlighter->pLines == NULL) {
+        return DR_FALSE;
+    }
+
+    if (!dred_mutex_create(&pHighlighter->worker.lock)) {
+        free(pHighlighter->pLines);
+        pHighlighter->pLines = NULL;
+        return DR_FALSE;
+    }
+
+    if (!dred_semaphore_create(&pHighlighter->worker.wakeup, 0)) {
+        dred_mutex_delete(&pHighlighter->worker.lock);
+        free(pHighlighter->pLines);
+        pHighlighter->pLines = NULL;
+        return DR_FALSE;
+    }
+
+    if (!dred_thread_create(&pHighlighter->worker.thread, dred_highlighter__thread_proc, pHighlighter)) {
+        dred_semaphore_delete(&pHighlighter->worker.wakeup);
+        dred_mutex_delete(&pHighlighter->worker.lock);
+        free(pHighlighter->pLines);
+        pHighlighter->pLines = NULL;
+        return DR_FALSE;
+    }
+
+    pHighlighter->worker.isRunning = DR_TRUE;
+    return DR_TRUE;
+}
+
+void dred_highlighter_uninit(dred_highlighter* pHighlighter)
+{
+    if (pHighlighter == NULL) {
+        return;
+    }
+
+    if (pHighlighter->worker.isRunning) {
+        dred_mutex_lock(&pHighlighter->worker.lock);
+        pHighlighter->worker.isTerminating = DR_TRUE;
+        dred_mutex_unlock(&pHighlighter->worker.lock);
+
+        dred_semaphore_release(&pHighlighter->worker.wakeup);
+        dred_thread_wait(&pHighlighter->worker.thread);
+
+        dred_highlighter__delete_job(pHighlighter->worker.pJob);
+        dred_highlighter__delete_result(pHighlighter->worker.pResult);
+        dred_semaphore_delete(&pHighlighter->worker.wakeup);
+        dred_mutex_delete(&pHighlighter->worker.lock);
+    }
+
+    if (pHighlighter->pTimer != NULL) {
+        dred_timer_delete(pHighlighter->pTimer);
+    }
+
+    if (pHighlighter->pLines != NULL) {
+        for (size_t i = 0; i < DRED_HIGHLIGHT_CACHE_SET_COUNT*DRED_HIGHLIGHT_CACHE_WAY_COUNT; ++i) {
+            free(pHighlighter->pLines[i].pSpans);
+        }
+
+        free(pHighlighter->pLines);
+    }
+
+    pHighlighter->pEngine = NULL;
+    pHighlighter->onGetHighlights = NULL;
+    pHighlighter->pLines = NULL;
+    pHighlighter->pTimer = NULL;
+    memset(&pHighlighter->worker, 0, sizeof(pHighlighter->worker));
+}
+
+
+const dred_highlight_language* dred_find_highlight_language(const char* name)
+{
+    if (name == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < DRED_LANGUAGE_COUNT; ++i) {
+        if (strcmp(g_Languages[i]->name, name) == 0) {
+            return g_Languages[i];
+        }
+    }
+
+    return NULL;
+}
+
+const dred_highlight_language* dred_find_highlight_language_by_file_path(const char* filePath)
+{
+    if (filePath == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < DRED_LANGUAGE_COUNT; ++i) {
+        for (const char** ppExtension = g_Languages[i]->ppExtensions; *ppExtension != NULL; ++ppExtension) {
+            if (drpath_extension_equal(filePath, *ppExtension)) {
+                return g_Languages[i];
+            }
+        }
+    }
+
+    return NULL;
 }
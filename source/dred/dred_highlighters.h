@@ -14,22 +14,140 @@ typedef enum
 typedef struct
 {
     const char* keyword;
+    size_t length;
     dred_highlight_category category;
 } dred_highlight_keyword;
 
-static dred_highlight_keyword g_KeywordsC[] = {
-    { "char",     dred_highlight_category_datatype },
-    { "short",    dred_highlight_category_datatype },
-    { "int",      dred_highlight_category_datatype },
-    { "float",    dred_highlight_category_datatype },
-    { "unsigned", dred_highlight_category_datatype }
-};
+// A minimal perfect hash table of keywords, generated by dred_build from the data files in resources/languages. Each keyword hashes to
+// one of bucketCount buckets, and the bucket's displacement picks the keyword's slot. See dred_highlighter__get_keyword_slot().
+typedef struct
+{
+    const dred_highlight_keyword* pKeywords;    // Indexed by slot.
+    size_t keywordCount;
+    const uint16_t* pDisplacements;             // Indexed by bucket.
+    size_t bucketCount;
+} dred_highlight_keyword_table;
+
+// A lexer is a DFA that is compiled by dred_build from the language's definition file. Each byte maps to a character class, and each
+// state has a transition for each class. Transitions into states where a token can end have DRED_LEXER_ACCEPT_BIT set. Tokens are
+// the longest run of characters that ends in such a state.
+#define DRED_LEXER_DEAD_STATE           0xFFFF
+#define DRED_LEXER_ACCEPT_BIT           0x8000
+
+// Flags for each state of a lexer.
+#define DRED_LEXER_STATE_IDENTIFIER     (1 << 0)    // Tokens ending in this state are looked up in the keyword table.
+#define DRED_LEXER_STATE_CONTINUES      (1 << 1)    // A token that is still in this state at the end of a line carries on to the next.
+
+typedef struct
+{
+    const char* name;
+    const char** ppExtensions;                  // NULL terminated.
+
+    uint16_t stateCount;
+    uint16_t classCount;
+    const uint8_t* pCharClasses;                // 256 entries.
+    const uint16_t* pTransitions;               // stateCount*classCount entries.
+    const uint8_t* pStateCategories;            // The category of a token that ends in each state.
+    const uint8_t* pStateFlags;
+
+    const dred_highlight_keyword_table* pKeywords;
+} dred_highlight_language;
+
+// The languages that are generated by dred_build. Each line is the definition file in resources/languages followed by the name of
+// the language. See resources/languages/c.txt for the format of a definition file.
+//
+// BEGIN LANGUAGE LIST
+// c.txt      c
+// cpp.txt    cpp
+// python.txt python
+// rust.txt   rust
+// shell.txt  shell
+// END LANGUAGE LIST
+
+// The state the lexer is in at the start of a line. This is what gets stored in the text engine's line cache. Any other state is one
+// of the lexer's states that continues across lines, such as the inside of a block comment.
+#define DRED_HIGHLIGHT_STATE_DEFAULT        0
+
+// The highlighted lines are cached by content. Each line maps to a set of DRED_HIGHLIGHT_CACHE_WAY_COUNT lines and the least
+// recently used one is replaced. The set count must be a power of two.
+#define DRED_HIGHLIGHT_CACHE_SET_COUNT      512
+#define DRED_HIGHLIGHT_CACHE_WAY_COUNT      8
+
+// How often the UI thread checks whether or not the highlighting thread has finished, in milliseconds.
+#define DRED_HIGHLIGHT_TIMER_INTERVAL       10
+
+// A run of characters that need to be highlighted. The character indices are relative to the start of the line.
+typedef struct
+{
+    size_t iCharBeg;
+    size_t iCharEnd;
+    dred_highlight_category category;
+} dred_highlight_span;
+
+// A highlighted line. This is keyed on the content of the line and the state the lexer was in at the start of it, so a line keeps
+// its highlighting when the text around it changes.
+typedef struct
+{
+    uint64_t hash;
+    size_t length;
+    uint32_t state;
+    uint32_t lastUsed;      // Set to 0 when the line is empty.
+    dred_highlight_span* pSpans;
+    size_t spanCount;
+    size_t spanCapacity;
+} dred_highlight_line;
+
+// A request for the highlighting thread. This holds a copy of the text of a range of lines as it was at the given version, along with
+// the state each of those lines was known to start in. It is never modified by the UI thread after it's been handed over.
+typedef struct
+{
+    uint64_t textVersion;
+    size_t iFirstLine;
+    size_t lineCount;
+    uint32_t* pStates;
+    dr_bool32* pIsDirty;
+    char* pText;
+    size_t textLength;
+} dred_highlight_job;
+
+// A line that was lexed by the highlighting thread. The spans are stored in the pSpans array of the result.
+typedef struct
+{
+    size_t iLine;
+    uint64_t hash;
+    size_t length;
+    uint32_t state;
+    size_t iFirstSpan;
+    size_t spanCount;
+} dred_highlight_result_line;
+
+// The result of a job. If the text has changed since the job was made the result is thrown away.
+typedef struct
+{
+    uint64_t textVersion;
+
+    // The state each line covered by the job starts in, and the state the line after them starts in. If the last line didn't need to
+    // be lexed the state of the line after it is already correct.
+    size_t iFirstLine;
+    size_t lineCount;
+    uint32_t* pStates;
+    uint32_t nextState;
+    dr_bool32 isLastLineLexed;
+
+    // The lines that were lexed.
+    dred_highlight_result_line* pLexedLines;
+    size_t lexedLineCount;
+    size_t lexedLineCapacity;
+    dred_highlight_span* pSpans;
+    size_t spanCount;
+    size_t spanCapacity;
+} dred_highlight_result;
 
 typedef struct
 {
     dred_context* pDred;
     drte_engine* pEngine;
-    drte_engine_on_get_next_highlight_proc onNextHighlight;
+    drte_engine_on_get_highlights_proc onGetHighlights;
 
     union
     {
@@ -46,16 +164,53 @@ typedef struct
         } cpp;
     } styles;
 
-    union
+    const dred_highlight_language* pLanguage;
+
+    // The cache of highlighted lines. This is only ever touched by the UI thread.
+    dred_highlight_line* pLines;
+    uint32_t clock;
+
+    // The last line that was painted while it still needed highlighting. The next job covers every dirty line up to this one.
+    size_t iRequestedLine;
+    dr_bool32 hasRequest;
+
+    // The timer that collects results from the highlighting thread. This only exists while there is work to do.
+    dred_timer* pTimer;
+
+    // The highlighting thread. Everything in here is protected by the mutex, except for the thread itself and isJobInProgress which
+    // are only used by the UI thread.
+    struct
     {
-        struct
-        {
-            dred_highlight_keyword* keywords;
-            size_t keywordCount;
-        } builtin;
-    } data;
+        dred_thread thread;
+        dred_mutex lock;
+        dred_semaphore wakeup;
+        dr_bool32 isRunning;
+        dr_bool32 isJobInProgress;
+        dr_bool32 isTerminating;
+        uint64_t latestTextVersion;
+        dred_highlight_job* pJob;
+        dred_highlight_result* pResult;
+    } worker;
     
 } dred_highlighter;
 
+// Initializes a highlighter for the given engine. The styles are left alone since they are managed by the text editor.
 //
-dr_bool32 dred_highlighter_init(dred_highlighter* pHighlighter, dred_context* pDred, drte_engine* pEngine, dred_highlight_keyword* keywords, size_t keywordCount);
+// Lexing is done on a separate thread so that a change that affects everything below it, such as opening a block comment near the
+// top of a large file, never stalls the UI. The state the lexer is in at the start of each line is stored in the engine's line cache.
+// When the text changes only the edited lines are marked as dirty. When a line that needs highlighting is painted, a copy of the text
+// from the first dirty line down to that line is handed to the highlighting thread. It lexes the dirty lines, carrying on to the
+// following lines only until a line ends in the state the next line was already known to start in. Until the results come back the
+// line is painted with the default style.
+dr_bool32 dred_highlighter_init(dred_highlighter* pHighlighter, dred_context* pDred, drte_engine* pEngine, const dred_highlight_language* pLanguage);
+
+// Uninitializes a highlighter. This waits for the highlighting thread to finish. This is safe to call on a zeroed highlighter that
+// was never initialized.
+void dred_highlighter_uninit(dred_highlighter* pHighlighter);
+
+
+// Finds a language by its name, such as "c". Returns NULL if there is no such language.
+const dred_highlight_language* dred_find_highlight_language(const char* name);
+
+// Finds the language of a file based on its extension. Returns NULL if the extension isn't recognized.
+const dred_highlight_language* dred_find_highlight_language_by_file_path(const char* filePath);
@@ -1045,6 +1045,16 @@ dr_bool32 dred_window_is_maximized__win32(dred_window* pWindow)
     return IsZoomed(pWindow->hWnd);
 }
 
+void dred_window_flush_dirty__win32(dred_window* pWindow)
+{
+    if (pWindow == NULL) {
+        return;
+    }
+
+    // Dirty regions are already redrawn immediately on Win32. This just makes sure anything invalidated by the system is too.
+    UpdateWindow(pWindow->hWnd);
+}
+
 
 void dred_window_set_cursor__win32(dred_window* pWindow, dred_cursor_type cursor)
 {
@@ -1967,18 +1977,14 @@ static void dred_gtk_cb__on_paint(GtkWidget* pGTKWindow, cairo_t* pCairoContext,
     // NOTE: Because we are using dr_2d to draw the GUI, the last argument to dred_control_draw() must be a pointer
     //       to the relevant dr2d_surface object.
 
-    double clipLeft;
-    double clipTop;
-    double clipRight;
-    double clipBottom;
-    cairo_clip_extents(pCairoContext, &clipLeft, &clipTop, &clipRight, &clipBottom);
+    // The drawing surface keeps everything that has been drawn to it, so only the regions that have been marked as dirty are
+    // redrawn. Anything else GTK asks for, such as when the window is uncovered or when pixels have been scrolled, is already up
+    // to date and just needs to be copied to the window. Each rectangle is redrawn separately rather than their bounds so that small
+    // changes in different parts of the window don't result in everything in between being redrawn too.
+    dred_dirty_region drawRegion = pWindow->gtkPaintRegion;
+    dred_dirty_region_init(&pWindow->gtkPaintRegion);
 
-    dred_rect drawRect;
-    drawRect.left   = (float)clipLeft;
-    drawRect.top    = (float)clipTop;
-    drawRect.right  = (float)clipRight;
-    drawRect.bottom = (float)clipBottom;
-    dred_control_draw(pWindow->pRootGUIControl, drawRect, pWindow->pDrawingSurface);
+    dred_control_draw_region(pWindow->pRootGUIControl, &drawRegion, pWindow->pDrawingSurface);
 
     // At this point the GUI has been drawn, however nothing has been drawn to the window yet. To do this we will
     // use cairo directly with a cairo_set_source_surface() / cairo_paint() pair. We can get a pointer to dr_2d's
@@ -2020,6 +2026,10 @@ static dr_bool32 dred_gtk_cb__on_configure(GtkWidget* pGTKWindow, GdkEventConfig
         }
         pWindow->pDrawingSurface = dr2d_create_surface(pWindow->pDred->pDrawingContext, (float)pEvent->width, (float)pEvent->height);
 
+        // The new surface is empty so everything needs to be redrawn.
+        dred_dirty_region_init(&pWindow->gtkPaintRegion);
+        dred_dirty_region_add(&pWindow->gtkPaintRegion, dred_make_rect(0, 0, (float)pEvent->width, (float)pEvent->height));
+
 
         // Post the event.
         dred_window_on_size(pWindow, pEvent->width, pEvent->height);
@@ -2346,6 +2356,9 @@ dred_window* dred_window_create__gtk__internal(dred_context* pDred, GtkWidget* p
     pWindow->pDred = pDred;
     pWindow->pGTKWindow = pGTKWindow;
     pWindow->isShowingMenu = DR_TRUE;
+    dred_dirty_region_init(&pWindow->gtkDirtyRegion);
+    dred_dirty_region_init(&pWindow->gtkScrolledRegion);
+    dred_dirty_region_init(&pWindow->gtkPaintRegion);
 
     pWindow->pRootGUIControl = &pWindow->rootGUIControl;
     if (!dred_platform__init_root_gui_element(pWindow->pRootGUIControl, pDred, pWindow)) {
@@ -2468,6 +2481,10 @@ void dred_window_delete__gtk(dred_window* pWindow)
         dred_gtk__delete_accels(pWindow->pAccels, pWindow->accelCount);
     }
 
+    if (pWindow->gtkDirtyTickCallbackID != 0) {
+        gtk_widget_remove_tick_callback(pWindow->pGTKClientArea, pWindow->gtkDirtyTickCallbackID);
+    }
+
     dred_control_uninit(pWindow->pRootGUIControl);
     dr2d_delete_surface(pWindow->pDrawingSurface);
 
@@ -2577,6 +2594,79 @@ dr_bool32 dred_window_is_maximized__gtk(dred_window* pWindow)
     return gtk_window_is_maximized(GTK_WINDOW(pWindow->pGTKWindow));
 }
 
+static void dred_window__queue_dirty_rect__gtk(dred_window* pWindow)
+{
+    assert(pWindow != NULL);
+
+    if (pWindow->gtkDirtyTickCallbackID != 0) {
+        gtk_widget_remove_tick_callback(pWindow->pGTKClientArea, pWindow->gtkDirtyTickCallbackID);
+        pWindow->gtkDirtyTickCallbackID = 0;
+    }
+
+    // Each rectangle is queued separately so GTK only repaints the area that actually changed.
+    for (size_t iRect = 0; iRect < pWindow->gtkDirtyRegion.count; ++iRect) {
+        dred_rect dirtyRect = pWindow->gtkDirtyRegion.rects[iRect];
+        gtk_widget_queue_draw_area(pWindow->pGTKClientArea,
+            (gint)dirtyRect.left, (gint)dirtyRect.top, (gint)(dirtyRect.right - dirtyRect.left), (gint)(dirtyRect.bottom - dirtyRect.top));
+        dred_dirty_region_add(&pWindow->gtkPaintRegion, dirtyRect);
+    }
+
+    // Scrolled pixels only need to be copied to the window so they aren't added to the paint region.
+    for (size_t iRect = 0; iRect < pWindow->gtkScrolledRegion.count; ++iRect) {
+        dred_rect scrolledRect = pWindow->gtkScrolledRegion.rects[iRect];
+        gtk_widget_queue_draw_area(pWindow->pGTKClientArea,
+            (gint)scrolledRect.left, (gint)scrolledRect.top, (gint)(scrolledRect.right - scrolledRect.left), (gint)(scrolledRect.bottom - scrolledRect.top));
+    }
+
+    dred_dirty_region_init(&pWindow->gtkDirtyRegion);
+    dred_dirty_region_init(&pWindow->gtkScrolledRegion);
+}
+
+static gboolean dred_gtk_cb__on_dirty_tick(GtkWidget* pGTKWidget, GdkFrameClock* pFrameClock, gpointer pUserData)
+{
+    (void)pGTKWidget;
+
+    dred_window* pWindow = pUserData;
+    if (pWindow == NULL) {
+        return G_SOURCE_REMOVE;
+    }
+
+    // If the frame clock is running faster than DRED_MAX_PAINTS_PER_SECOND the flush is held back until a later frame. The next
+    // flush time is advanced from the previous one rather than from the current frame so that small amounts of jitter in the frame
+    // clock don't cause frames to be skipped.
+    gint64 frameTime = gdk_frame_clock_get_frame_time(pFrameClock);
+    if (frameTime < pWindow->gtkNextFlushTime) {
+        return G_SOURCE_CONTINUE;
+    }
+
+    gint64 flushInterval = 1000000 / DRED_MAX_PAINTS_PER_SECOND;
+    if (frameTime - pWindow->gtkNextFlushTime >= flushInterval) {
+        pWindow->gtkNextFlushTime = frameTime + flushInterval;
+    } else {
+        pWindow->gtkNextFlushTime += flushInterval;
+    }
+
+    // Tick callbacks are run before the frame is painted, so the region queued here is painted in this frame.
+    pWindow->gtkDirtyTickCallbackID = 0;
+    dred_window__queue_dirty_rect__gtk(pWindow);
+
+    return G_SOURCE_REMOVE;
+}
+
+void dred_window_flush_dirty__gtk(dred_window* pWindow)
+{
+    if (pWindow == NULL) {
+        return;
+    }
+
+    dred_window__queue_dirty_rect__gtk(pWindow);
+
+    GdkWindow* pGDKWindow = gtk_widget_get_window(pWindow->pGTKClientArea);
+    if (pGDKWindow != NULL) {
+        gdk_window_process_updates(pGDKWindow, TRUE);
+    }
+}
+
 
 void dred_window_set_cursor__gtk(dred_window* pWindow, dred_cursor_type cursor)
 {
@@ -3197,18 +3287,89 @@ static void dred_platform__on_global_dirty__gtk(dred_control* pControl, dred_rec
         dred_rect absoluteRect = relativeRect;
         dred_make_rect_absolute(pControl, &absoluteRect);
 
+        // The region isn't redrawn straight away. Instead it's accumulated and flushed on the next frame so that many dirties in a
+        // row, such as from key repeat or scrolling, only result in a single paint. Use dred_window_flush_dirty() to force an
+        // immediate redraw.
         if (dred_rect_has_volume(absoluteRect)) {
-            gtk_widget_queue_draw_area(pWindow->pGTKClientArea,
-                (gint)absoluteRect.left, (gint)absoluteRect.top, (gint)(absoluteRect.right - absoluteRect.left), (gint)(absoluteRect.bottom - absoluteRect.top));
-
-            // Redraw immediately.
-            GdkWindow* pGDKWindow = gtk_widget_get_window(pWindow->pGTKClientArea);
-            if (pGDKWindow != NULL) {
-                gdk_window_process_updates(pGDKWindow, TRUE);
+            dred_dirty_region_add(&pWindow->gtkDirtyRegion, absoluteRect);
+            if (pWindow->gtkDirtyTickCallbackID == 0) {
+                pWindow->gtkDirtyTickCallbackID = gtk_widget_add_tick_callback(pWindow->pGTKClientArea, dred_gtk_cb__on_dirty_tick, pWindow, NULL);
             }
         }
     }
 }
+
+static dr_bool32 dred_platform__on_global_scroll_pixels__gtk(dred_control* pControl, dred_rect relativeRect, float offsetX, float offsetY)
+{
+    dred_window* pWindow = dred_get_control_window(pControl);
+    if (pWindow == NULL || pWindow->pGTKWindow == NULL || pWindow->pDrawingSurface == NULL) {
+        return DR_FALSE;
+    }
+
+    cairo_surface_t* pCairoSurface = dr2d_get_cairo_surface_t(pWindow->pDrawingSurface);
+    if (pCairoSurface == NULL || cairo_surface_get_type(pCairoSurface) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return DR_FALSE;
+    }
+
+    int surfaceWidth  = cairo_image_surface_get_width(pCairoSurface);
+    int surfaceHeight = cairo_image_surface_get_height(pCairoSurface);
+
+    dred_rect absoluteRect = relativeRect;
+    dred_make_rect_absolute(pControl, &absoluteRect);
+    absoluteRect = dred_clamp_rect(absoluteRect, dred_make_rect(0, 0, (float)surfaceWidth, (float)surfaceHeight));
+
+    // Pixels can only be moved as-is when everything lines up with the pixel grid.
+    int left   = (int)absoluteRect.left;
+    int top    = (int)absoluteRect.top;
+    int right  = (int)absoluteRect.right;
+    int bottom = (int)absoluteRect.bottom;
+    int moveX  = (int)offsetX;
+    int moveY  = (int)offsetY;
+    if ((float)left != absoluteRect.left || (float)top != absoluteRect.top || (float)right != absoluteRect.right || (float)bottom != absoluteRect.bottom ||
+        (float)moveX != offsetX || (float)moveY != offsetY) {
+        return DR_FALSE;
+    }
+
+    int movedWidth  = (right  - left) - abs(moveX);
+    int movedHeight = (bottom - top)  - abs(moveY);
+    if (movedWidth <= 0 || movedHeight <= 0) {
+        return DR_FALSE;
+    }
+
+    int srcX = left + ((moveX < 0) ? -moveX : 0);
+    int srcY = top  + ((moveY < 0) ? -moveY : 0);
+    int dstX = srcX + moveX;
+    int dstY = srcY + moveY;
+
+    cairo_surface_flush(pCairoSurface);
+
+    unsigned char* pPixels = cairo_image_surface_get_data(pCairoSurface);
+    if (pPixels == NULL) {
+        return DR_FALSE;
+    }
+
+    // When moving down the rows are copied from the bottom up so that rows aren't overwritten before they've been copied.
+    int stride = cairo_image_surface_get_stride(pCairoSurface);
+    for (int iRow = 0; iRow < movedHeight; ++iRow) {
+        int y = (moveY > 0) ? (movedHeight - iRow - 1) : iRow;
+        memmove(pPixels + (dstY + y)*stride + dstX*4, pPixels + (srcY + y)*stride + srcX*4, (size_t)movedWidth*4);
+    }
+
+    cairo_surface_mark_dirty_rectangle(pCairoSurface, dstX, dstY, movedWidth, movedHeight);
+
+
+    // Anything still waiting to be redrawn was going to be drawn over the old position of the pixels, so it needs to be drawn over
+    // their new position as well.
+    dred_dirty_region_scroll(&pWindow->gtkDirtyRegion, absoluteRect, offsetX, offsetY);
+    dred_dirty_region_scroll(&pWindow->gtkPaintRegion, absoluteRect, offsetX, offsetY);
+
+    dred_dirty_region_add(&pWindow->gtkScrolledRegion, dred_make_rect((float)dstX, (float)dstY, (float)(dstX + movedWidth), (float)(dstY + movedHeight)));
+    if (pWindow->gtkDirtyTickCallbackID == 0) {
+        pWindow->gtkDirtyTickCallbackID = gtk_widget_add_tick_callback(pWindow->pGTKClientArea, dred_gtk_cb__on_dirty_tick, pWindow, NULL);
+    }
+
+    return DR_TRUE;
+}
 #endif
 
 
@@ -3320,6 +3481,7 @@ void dred_platform_bind_gui(dred_gui* pGUI)
     dred_gui_set_global_on_capture_keyboard(pGUI, dred_platform__on_global_capture_keyboard__gtk);
     dred_gui_set_global_on_release_keyboard(pGUI, dred_platform__on_global_release_keyboard__gtk);
     dred_gui_set_global_on_dirty(pGUI, dred_platform__on_global_dirty__gtk);
+    dred_gui_set_global_on_scroll_pixels(pGUI, dred_platform__on_global_scroll_pixels__gtk);
 #endif
 
     dred_gui_set_global_on_change_cursor(pGUI, dred_platform__on_global_change_cursor);
@@ -3546,6 +3708,17 @@ dr_bool32 dred_window_is_maximized(dred_window* pWindow)
 #endif
 }
 
+void dred_window_flush_dirty(dred_window* pWindow)
+{
+#ifdef DRED_WIN32
+    dred_window_flush_dirty__win32(pWindow);
+#endif
+
+#ifdef DRED_GTK
+    dred_window_flush_dirty__gtk(pWindow);
+#endif
+}
+
 
 void dred_window_set_cursor(dred_window* pWindow, dred_cursor_type cursor)
 {
@@ -175,6 +175,22 @@ struct dred_window
     // moved and thus need to have the on_move event posted.
     int windowPosX;
     int windowPosY;
+
+    // The region of the client area that has been marked as dirty since the last frame. Dirty regions are accumulated and then
+    // passed to GTK in one go from a tick callback on the frame clock. The tick callback is only installed while something is dirty.
+    dred_dirty_region gtkDirtyRegion;
+    guint gtkDirtyTickCallbackID;
+
+    // The region of the client area whose pixels have been moved within the drawing surface since the last frame. These pixels
+    // don't need to be redrawn, but they still need to be copied to the window.
+    dred_dirty_region gtkScrolledRegion;
+
+    // The region that has been passed to GTK and needs to be redrawn by the next paint. Anything else GTK asks to be painted is
+    // already up to date in the drawing surface.
+    dred_dirty_region gtkPaintRegion;
+
+    // The frame time before which the next flush of the dirty region is held back. This keeps paints at DRED_MAX_PAINTS_PER_SECOND.
+    gint64 gtkNextFlushTime;
 #endif
 };
 
@@ -216,6 +232,9 @@ void dred_window_bring_to_top(dred_window* pWindow);
 // Determines whether or not the window is maximized.
 dr_bool32 dred_window_is_maximized(dred_window* pWindow);
 
+// Immediately repaints the parts of the window that have been marked as dirty. Normally these are repainted on the next frame.
+void dred_window_flush_dirty(dred_window* pWindow);
+
 // Sets the cursor to use with the window.
 void dred_window_set_cursor(dred_window* pWindow, dred_cursor_type cursor);
 dr_bool32 dred_window_is_cursor_over(dred_window* pWindow);
@@ -14,7 +14,7 @@ void dred_text_editor__register_style(dred_text_editor* pTextEditor, dred_text_s
     dred_gui_font_metrics fontMetrics;
     dred_gui_get_font_metrics(pStyle->pFont, &fontMetrics);
 
-    drte_font_metrics drteFontMetrics = drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth);
+    drte_font_metrics drteFontMetrics = drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace);
     drte_engine_register_style_token(dred_textview_get_engine(dred_text_editor__get_textview(pTextEditor)), (drte_style_token)pStyle, drteFontMetrics);
 }
 
@@ -336,6 +336,7 @@ void dred_text_editor_delete(dred_text_editor* pTextEditor)
         return;
     }
 
+    dred_highlighter_uninit(&pTextEditor->highlighter);
     dred_textview_uninit(pTextEditor->pTextView);
     drte_engine_uninit(&pTextEditor->engine);
 
@@ -477,6 +478,10 @@ void dred_text_editor_refresh_styling(dred_text_editor* pTextEditor)
         pTextEditor->highlighter.styles.common.keyword.fgColor = pDred->config.cppKeywordTextColor;
         dred_text_editor__register_style(pTextEditor, &pTextEditor->highlighter.styles.common.keyword);
 
+        // The engine holds on to the highlights it's been given, which may have been resolved against styles that weren't registered
+        // until just now.
+        drte_engine_invalidate_highlights(dred_textview_get_engine(dred_text_editor__get_textview(pTextEditor)));
+
 
         dred_textview_set_font(pTextEditor->pTextView, dred_font_acquire_subfont(pDred->config.pTextEditorFont, pDred->uiScale));    // TODO: <-- This font needs to be unacquired.
         dred_textview_set_text_color(pTextEditor->pTextView, pDred->config.textEditorTextColor);
@@ -541,19 +546,14 @@ void dred_text_editor_set_highlighter(dred_text_editor* pTextEditor, const char*
     dred_context* pDred = dred_control_get_context(DRED_CONTROL(pTextEditor));
     assert(pDred != NULL);
 
-    if (lang == NULL) {
-        drte_engine_set_highlighter(pEngine, NULL, NULL);
-    } else {
-        // Unfortunately highlighting is not quite ready for prime time.
-        drte_engine_set_highlighter(pEngine, NULL, NULL);
-        (void)pDred;
-        (void)pTextEditor;
-#if 0
-        if (strcmp(lang, "c") == 0) {
-            dred_highlighter_init(&pTextEditor->highlighter, pDred, dred_textview_get_engine(pTextEditor->pTextView), g_KeywordsC, sizeof(g_KeywordsC) / sizeof(g_KeywordsC[0]));
-            drte_engine_set_highlighter(dred_textview_get_engine(pTextEditor->pTextView), pTextEditor->highlighter.onNextHighlight, &pTextEditor->highlighter);
+    drte_engine_set_highlighter(pEngine, NULL, NULL);
+    dred_highlighter_uninit(&pTextEditor->highlighter);
+
+    const dred_highlight_language* pLanguage = dred_find_highlight_language(lang);
+    if (pLanguage != NULL) {
+        if (dred_highlighter_init(&pTextEditor->highlighter, pDred, pEngine, pLanguage)) {
+            drte_engine_set_highlighter(pEngine, pTextEditor->highlighter.onGetHighlights, &pTextEditor->highlighter);
         }
-#endif
     }
 }
 
@@ -671,13 +671,13 @@ dr_bool32 dred_text_editor_find_and_replace_next(dred_text_editor* pTextEditor,
     return dred_textview_find_and_replace_next(pTextEditor->pTextView, text, replacement);
 }
 
-dr_bool32 dred_text_editor_find_and_replace_all(dred_text_editor* pTextEditor, const char* text, const char* replacement)
+size_t dred_text_editor_find_and_replace_all(dred_text_editor* pTextEditor, const char* text, const char* replacement)
 {
     if (pTextEditor == NULL) {
-        return DR_FALSE;
+        return 0;
     }
 
-    dr_bool32 result = DR_FALSE;
+    size_t result = 0;
     dred_control_begin_dirty(DRED_CONTROL(pTextEditor));
     {
         result = dred_textview_find_and_replace_all(pTextEditor->pTextView, text, replacement);
@@ -686,6 +686,39 @@ dr_bool32 dred_text_editor_find_and_replace_all(dred_text_editor* pTextEditor, c
     return result;
 }
 
+dr_bool32 dred_text_editor_find_regex_and_select_next(dred_text_editor* pTextEditor, drte_regex* pRegex)
+{
+    if (pTextEditor == NULL) {
+        return DR_FALSE;
+    }
+
+    return dred_textview_find_regex_and_select_next(pTextEditor->pTextView, pRegex);
+}
+
+dr_bool32 dred_text_editor_find_regex_and_replace_next(dred_text_editor* pTextEditor, drte_regex* pRegex, const char* replacement)
+{
+    if (pTextEditor == NULL) {
+        return DR_FALSE;
+    }
+
+    return dred_textview_find_regex_and_replace_next(pTextEditor->pTextView, pRegex, replacement);
+}
+
+size_t dred_text_editor_find_regex_and_replace_all(dred_text_editor* pTextEditor, drte_regex* pRegex, const char* replacement)
+{
+    if (pTextEditor == NULL) {
+        return 0;
+    }
+
+    size_t result = 0;
+    dred_control_begin_dirty(DRED_CONTROL(pTextEditor));
+    {
+        result = dred_textview_find_regex_and_replace_all(pTextEditor->pTextView, pRegex, replacement);
+    }
+    dred_control_end_dirty(DRED_CONTROL(pTextEditor));
+    return result;
+}
+
 
 void dred_text_editor_set_text_scale(dred_text_editor* pTextEditor, float textScale)
 {
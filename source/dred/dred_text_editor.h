@@ -113,8 +113,17 @@ dr_bool32 dred_text_editor_find_and_select_next(dred_text_editor* pTextEditor, c
 // Finds the next occurance of the given string and replaces it with another.
 dr_bool32 dred_text_editor_find_and_replace_next(dred_text_editor* pTextEditor, const char* text, const char* replacement);
 
-// Finds every occurance of the given string and replaces it with another.
-dr_bool32 dred_text_editor_find_and_replace_all(dred_text_editor* pTextEditor, const char* text, const char* replacement);
+// Finds every occurance of the given string and replaces it with another. Returns the number of occurances that were replaced.
+size_t dred_text_editor_find_and_replace_all(dred_text_editor* pTextEditor, const char* text, const char* replacement);
+
+// Finds and selects the next match of the given regular expression, starting from the cursor and looping back to the start.
+dr_bool32 dred_text_editor_find_regex_and_select_next(dred_text_editor* pTextEditor, drte_regex* pRegex);
+
+// Finds the next match of the given regular expression and replaces it. The replacement can refer to groups with \1 to \9.
+dr_bool32 dred_text_editor_find_regex_and_replace_next(dred_text_editor* pTextEditor, drte_regex* pRegex, const char* replacement);
+
+// Finds every match of the given regular expression and replaces it. Returns the number of matches that were replaced.
+size_t dred_text_editor_find_regex_and_replace_all(dred_text_editor* pTextEditor, drte_regex* pRegex, const char* replacement);
 
 
 // Sets the scale of the internal text.
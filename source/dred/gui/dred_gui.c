@@ -787,6 +787,13 @@ void dred_gui_set_global_on_dirty(dred_gui * pGUI, dred_gui_on_dirty_proc onDirt
     }
 }
 
+void dred_gui_set_global_on_scroll_pixels(dred_gui* pGUI, dred_gui_on_scroll_pixels_proc onScrollPixels)
+{
+    if (pGUI != NULL) {
+        pGUI->onGlobalScrollPixels = onScrollPixels;
+    }
+}
+
 void dred_gui_set_global_on_capture_mouse(dred_gui* pGUI, dred_gui_on_capture_mouse_proc onCaptureMouse)
 {
     if (pGUI != NULL) {
@@ -851,7 +858,7 @@ dr_bool32 dred_control_init(dred_control* pControl, dred_context* pDred, dred_co
     pControl->pGUI = pDred->pGUI;
     pControl->pParent = pParent;
     pControl->cursor = dred_cursor_type_default;
-    pControl->dirtyRect = dred_make_inside_out_rect();
+    dred_dirty_region_init(&pControl->dirtyRegion);
 
     // Add to the the hierarchy.
     dred_control__append_without_detach_or_redraw(pControl, pControl->pParent);
@@ -2128,7 +2135,7 @@ dred_control* dred_control_begin_dirty(dred_control* pControl)
             pGUI->dirtyControlBufferSize = newBufferSize;
         }
 
-        pGUI->ppDirtyControls[pGUI->dirtyCounter] = pTopLevelControl;
+        pGUI->ppDirtyControls[pGUI->dirtyControlCount] = pTopLevelControl;
         pGUI->dirtyControlCount += 1;
     }
 
@@ -2153,8 +2160,12 @@ void dred_control_end_dirty(dred_control* pControl)
     if (pGUI->dirtyCounter == 0)
     {
         for (size_t i = 0; i < pGUI->dirtyControlCount; ++i) {
-            dred_control__post_outbound_event_dirty_global(pGUI->ppDirtyControls[i], pGUI->ppDirtyControls[i]->dirtyRect);
-            pGUI->ppDirtyControls[i]->dirtyRect = dred_make_inside_out_rect();
+            dred_dirty_region* pDirtyRegion = &pGUI->ppDirtyControls[i]->dirtyRegion;
+            for (size_t iRect = 0; iRect < pDirtyRegion->count; ++iRect) {
+                dred_control__post_outbound_event_dirty_global(pGUI->ppDirtyControls[i], pDirtyRegion->rects[iRect]);
+            }
+
+            dred_dirty_region_init(pDirtyRegion);
         }
 
         pGUI->dirtyControlCount = 0;
@@ -2175,10 +2186,36 @@ void dred_control_dirty(dred_control* pControl, dred_rect relativeRect)
         return;
     }
 
-    pTopLevelControl->dirtyRect = dred_rect_union(pTopLevelControl->dirtyRect, dred_make_rect_absolute(pControl, &relativeRect));
+    dred_dirty_region_add(&pTopLevelControl->dirtyRegion, dred_make_rect_absolute(pControl, &relativeRect));
     dred_control_end_dirty(pControl);
 }
 
+dr_bool32 dred_control_scroll_pixels(dred_control* pControl, dred_rect relativeRect, float offsetX, float offsetY)
+{
+    if (pControl == NULL) {
+        return DR_FALSE;
+    }
+
+    dred_gui* pGUI = pControl->pGUI;
+    assert(pGUI != NULL);
+
+    if (pGUI->onGlobalScrollPixels == NULL || !dred_control_is_visible_recursive(pControl)) {
+        return DR_FALSE;
+    }
+
+    if (!pGUI->onGlobalScrollPixels(pControl, relativeRect, offsetX, offsetY)) {
+        return DR_FALSE;
+    }
+
+    // Anything that's still waiting to be posted was going to be drawn over the old position of the pixels, so it needs to be
+    // drawn over their new position as well.
+    dred_control* pTopLevelControl = dred_control_find_top_level_control(pControl);
+    assert(pTopLevelControl != NULL);
+
+    dred_dirty_region_scroll(&pTopLevelControl->dirtyRegion, dred_make_rect_absolute(pControl, &relativeRect), offsetX, offsetY);
+    return DR_TRUE;
+}
+
 
 dr_bool32 dred_control_draw_iteration_callback(dred_control* pControl, dred_rect* pRelativeRect, void* pUserData)
 {
@@ -2221,6 +2258,29 @@ void dred_control_draw(dred_control* pControl, dred_rect relativeRect, void* pPa
     pGUI->paintingCallbacks.drawEnd(pPaintData);
 }
 
+void dred_control_draw_region(dred_control* pControl, const dred_dirty_region* pRelativeRegion, void* pPaintData)
+{
+    if (pControl == NULL || pRelativeRegion == NULL) {
+        return;
+    }
+
+    dred_gui* pGUI = pControl->pGUI;
+    if (pGUI == NULL) {
+        return;
+    }
+
+    assert(pGUI->paintingCallbacks.drawBegin != NULL);
+    assert(pGUI->paintingCallbacks.drawEnd   != NULL);
+
+    pGUI->paintingCallbacks.drawBegin(pPaintData);
+    {
+        for (size_t iRect = 0; iRect < pRelativeRegion->count; ++iRect) {
+            dred_control_iterate_visible_elements(pControl, pRelativeRegion->rects[iRect], dred_control_draw_iteration_callback, pPaintData);
+        }
+    }
+    pGUI->paintingCallbacks.drawEnd(pPaintData);
+}
+
 void dred_control_get_clip(dred_control* pControl, dred_rect* pRelativeRect, void* pPaintData)
 {
     if (pControl == NULL || pControl->pGUI == NULL) {
@@ -2925,6 +2985,98 @@ dr_bool32 dred_rect_has_volume(dred_rect rect)
     return rect.right > rect.left && rect.bottom > rect.top;
 }
 
+dr_bool32 dred_rect_overlaps(dred_rect rect0, dred_rect rect1)
+{
+    return rect0.left < rect1.right && rect0.right > rect1.left && rect0.top < rect1.bottom && rect0.bottom > rect1.top;
+}
+
+
+float dred_dirty_region__area(dred_rect rect)
+{
+    return (rect.right - rect.left) * (rect.bottom - rect.top);
+}
+
+// The number of extra pixels that would be drawn if the two rectangles were merged, less the overhead of drawing a rectangle.
+float dred_dirty_region__merge_cost(dred_rect rect0, dred_rect rect1)
+{
+    return dred_dirty_region__area(dred_rect_union(rect0, rect1)) - dred_dirty_region__area(rect0) - dred_dirty_region__area(rect1) - DRED_DIRTY_RECT_OVERHEAD;
+}
+
+void dred_dirty_region__remove(dred_dirty_region* pRegion, size_t iRect)
+{
+    assert(pRegion != NULL);
+    assert(iRect < pRegion->count);
+
+    pRegion->rects[iRect] = pRegion->rects[pRegion->count-1];
+    pRegion->count -= 1;
+}
+
+void dred_dirty_region_init(dred_dirty_region* pRegion)
+{
+    if (pRegion == NULL) {
+        return;
+    }
+
+    pRegion->count = 0;
+}
+
+void dred_dirty_region_add(dred_dirty_region* pRegion, dred_rect rect)
+{
+    if (pRegion == NULL || !dred_rect_has_volume(rect)) {
+        return;
+    }
+
+    // Merging two rectangles can result in a rectangle that overlaps others, so this keeps going until nothing else can be merged.
+    for (;;) {
+        size_t iMerge = pRegion->count;
+        for (size_t iRect = 0; iRect < pRegion->count; ++iRect) {
+            if (dred_rect_overlaps(pRegion->rects[iRect], rect) || dred_dirty_region__merge_cost(pRegion->rects[iRect], rect) <= 0) {
+                iMerge = iRect;
+                break;
+            }
+        }
+
+        // If the region is full the rectangle is merged with whichever rectangle results in the least amount of extra drawing.
+        if (iMerge == pRegion->count && pRegion->count == DRED_MAX_DIRTY_RECTS) {
+            iMerge = 0;
+            for (size_t iRect = 1; iRect < pRegion->count; ++iRect) {
+                if (dred_dirty_region__merge_cost(pRegion->rects[iRect], rect) < dred_dirty_region__merge_cost(pRegion->rects[iMerge], rect)) {
+                    iMerge = iRect;
+                }
+            }
+        }
+
+        if (iMerge == pRegion->count) {
+            break;
+        }
+
+        rect = dred_rect_union(pRegion->rects[iMerge], rect);
+        dred_dirty_region__remove(pRegion, iMerge);
+    }
+
+    pRegion->rects[pRegion->count] = rect;
+    pRegion->count += 1;
+}
+
+void dred_dirty_region_scroll(dred_dirty_region* pRegion, dred_rect rect, float offsetX, float offsetY)
+{
+    if (pRegion == NULL) {
+        return;
+    }
+
+    // Adding rectangles can merge and reorder the existing ones, so a copy of the original region is iterated instead.
+    dred_dirty_region oldRegion = *pRegion;
+    for (size_t iRect = 0; iRect < oldRegion.count; ++iRect) {
+        dred_rect movedRect = dred_offset_rect(dred_clamp_rect(oldRegion.rects[iRect], rect), offsetX, offsetY);
+        dred_dirty_region_add(pRegion, dred_clamp_rect(movedRect, rect));
+    }
+}
+
+dr_bool32 dred_dirty_region_is_empty(const dred_dirty_region* pRegion)
+{
+    return pRegion == NULL || pRegion->count == 0;
+}
+
 
 
 
@@ -3152,6 +3304,7 @@ dr_bool32 dred_gui_get_font_metrics_dr_2d(dred_gui_resource font, dred_gui_font_
     pMetricsOut->descent    = metrics.descent;
     pMetricsOut->lineHeight = metrics.lineHeight;
     pMetricsOut->spaceWidth = metrics.spaceWidth;
+    pMetricsOut->isMonospace = metrics.isMonospace;
 
     return DR_TRUE;
 }
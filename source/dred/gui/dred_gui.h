@@ -155,6 +155,17 @@
 #define DRED_MAX_FONT_FAMILY_LENGTH  128
 #endif
 
+// The maximum number of rectangles making up a dirty region. Rectangles are merged when this is exceeded.
+#ifndef DRED_MAX_DIRTY_RECTS
+#define DRED_MAX_DIRTY_RECTS    8
+#endif
+
+// The cost of drawing a rectangle, in pixels, on top of it's area. Two rectangles are merged when drawing the area between them is
+// cheaper than drawing them separately.
+#ifndef DRED_DIRTY_RECT_OVERHEAD
+#define DRED_DIRTY_RECT_OVERHEAD    4096
+#endif
+
 typedef struct dred_gui dred_gui;
 typedef struct dred_control dred_control;
 typedef struct dred_color dred_color;
@@ -232,6 +243,7 @@ struct dred_gui_font_metrics
     int descent;
     int lineHeight;
     int spaceWidth;
+    dr_bool32 isMonospace;
 };
 
 /// Glyph metrics.
@@ -264,6 +276,13 @@ struct dred_rect
     float bottom;
 };
 
+/// Structure representing a region that needs to be redrawn as a small set of rectangles that do not overlap.
+typedef struct
+{
+    dred_rect rects[DRED_MAX_DIRTY_RECTS];
+    size_t count;
+} dred_dirty_region;
+
 typedef struct
 {
     dred_color bgColor;
@@ -355,6 +374,7 @@ typedef void (* dred_gui_on_key_up_proc)               (dred_control* pControl,
 typedef void (* dred_gui_on_printable_key_down_proc)   (dred_control* pControl, unsigned int character, int stateFlags);
 typedef void (* dred_gui_on_paint_proc)                (dred_control* pControl, dred_rect relativeRect, void* pPaintData);
 typedef void (* dred_gui_on_dirty_proc)                (dred_control* pControl, dred_rect relativeRect);
+typedef dr_bool32 (* dred_gui_on_scroll_pixels_proc)   (dred_control* pControl, dred_rect relativeRect, float offsetX, float offsetY);
 typedef dr_bool32 (* dred_gui_on_hittest_proc)              (dred_control* pControl, float relativePosX, float relativePosY);
 typedef void (* dred_gui_on_capture_mouse_proc)        (dred_control* pControl);
 typedef void (* dred_gui_on_release_mouse_proc)        (dred_control* pControl);
@@ -674,7 +694,7 @@ struct dred_control
     unsigned int flags;
 
     // The region of the element that's dirty.
-    dred_rect dirtyRect;
+    dred_dirty_region dirtyRegion;
 
 
     /// The function to call when the element's relative position moves.
@@ -786,6 +806,9 @@ struct dred_gui
     /// The global event callback to call when an element is marked as dirty.
     dred_gui_on_dirty_proc onGlobalDirty;
 
+    /// The global event callback to call when the already drawn pixels of an element need to be moved.
+    dred_gui_on_scroll_pixels_proc onGlobalScrollPixels;
+
     /// The global event handler to call when an element captures the mouse.
     dred_gui_on_capture_mouse_proc onGlobalCaptureMouse;
 
@@ -894,6 +917,13 @@ void dred_gui_post_inbound_event_printable_key_down(dred_gui* pGUI, unsigned int
 ///     container window as dirty to trigger an operating system level repaint of the window.
 void dred_gui_set_global_on_dirty(dred_gui* pGUI, dred_gui_on_dirty_proc onDirty);
 
+/// Registers the global on_scroll_pixels event callback.
+///
+/// @remarks
+///     This is called by dred_control_scroll_pixels() and allows an application to move the pixels that have already been drawn
+///     to the container window's surface rather than redrawing them. The callback should return DR_FALSE if it can't do this.
+void dred_gui_set_global_on_scroll_pixels(dred_gui* pGUI, dred_gui_on_scroll_pixels_proc onScrollPixels);
+
 /// Registers the global on_capture_mouse event callback.
 ///
 /// @remarks
@@ -1293,6 +1323,16 @@ void dred_control_end_dirty(dred_control* pControl);
 ///     This will not redraw the element immediately, but instead post a paint event.
 void dred_control_dirty(dred_control* pControl, dred_rect relativeRect);
 
+/// Moves the pixels inside the given region of the given element that have already been drawn by the given offset.
+///
+/// @remarks
+///     Pixels moved outside of the region are discarded. The parts of the region that are uncovered are not marked as dirty, so
+///     the caller needs to do that itself. Any pending dirty regions that overlap the region are moved along with the pixels.
+///     @par
+///     This returns DR_FALSE if the pixels could not be moved, in which case the caller needs to mark the whole region as dirty.
+///     The region should not be covered by any other element.
+dr_bool32 dred_control_scroll_pixels(dred_control* pControl, dred_rect relativeRect, float offsetX, float offsetY);
+
 
 /// Draws the given element.
 ///
@@ -1305,6 +1345,13 @@ void dred_control_dirty(dred_control* pControl, dred_rect relativeRect);
 ///     When using easy_draw to do drawing, pPaintData must be set to a pointer to the relevant easydraw_surface object.
 void dred_control_draw(dred_control* pControl, dred_rect relativeRect, void* pPaintData);
 
+/// Draws each rectangle of the given region of the given element.
+///
+/// @remarks
+///     The rectangles of the region are relative to the given element. This is the same as calling dred_control_draw() for each
+///     rectangle, except that drawing is only begun and ended once.
+void dred_control_draw_region(dred_control* pControl, const dred_dirty_region* pRelativeRegion, void* pPaintData);
+
 /// Retrieves the current clipping rectangle.
 void dred_control_get_clip(dred_control* pControl, dred_rect* pRelativeRect, void* pPaintData);
 
@@ -1506,6 +1553,31 @@ dr_bool32 dred_rect_equal(dred_rect rect0, dred_rect rect1);
 /// Determines whether or not the given rectangle has any volume (width and height > 0).
 dr_bool32 dred_rect_has_volume(dred_rect rect);
 
+/// Determines whether or not two rectangles overlap. Rectangles that only share an edge do not overlap.
+dr_bool32 dred_rect_overlaps(dred_rect rect0, dred_rect rect1);
+
+
+/// Initializes an empty dirty region.
+void dred_dirty_region_init(dred_dirty_region* pRegion);
+
+/// Adds a rectangle to the given dirty region.
+///
+/// @remarks
+///     The rectangles of a region never overlap. When the new rectangle overlaps another it is merged with it. Rectangles that don't
+///     overlap are also merged when drawing the area between them is cheaper than drawing each separately, or when there are more
+///     than DRED_MAX_DIRTY_RECTS of them.
+void dred_dirty_region_add(dred_dirty_region* pRegion, dred_rect rect);
+
+/// Adds the parts of the given dirty region that are inside the given rectangle again, moved by the given offset.
+///
+/// @remarks
+///     This is used when the pixels inside the rectangle have been moved so that anything that was waiting to be redrawn is also
+///     redrawn at the pixels' new position. The moved rectangles are clamped to the rectangle.
+void dred_dirty_region_scroll(dred_dirty_region* pRegion, dred_rect rect, float offsetX, float offsetY);
+
+/// Determines whether or not the given dirty region is empty.
+dr_bool32 dred_dirty_region_is_empty(const dred_dirty_region* pRegion);
+
 
 
 /////////////////////////////////////////////////////////////////
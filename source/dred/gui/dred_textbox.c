@@ -334,7 +334,7 @@ dr_bool32 dred_textbox_find_and_replace_next(dred_textbox* pTextBox, const char*
     return dred_textview_find_and_replace_next(DRED_TEXTVIEW(pTextBox), text, replacement);
 }
 
-dr_bool32 dred_textbox_find_and_replace_all(dred_textbox* pTextBox, const char* text, const char* replacement)
+size_t dred_textbox_find_and_replace_all(dred_textbox* pTextBox, const char* text, const char* replacement)
 {
     return dred_textview_find_and_replace_all(DRED_TEXTVIEW(pTextBox), text, replacement);
 }
@@ -206,8 +206,8 @@ dr_bool32 dred_textbox_find_and_select_next(dred_textbox* pTextBox, const char*
 // Finds the next occurance of the given string and replaces it with another.
 dr_bool32 dred_textbox_find_and_replace_next(dred_textbox* pTextBox, const char* text, const char* replacement);
 
-// Finds every occurance of the given string and replaces it with another.
-dr_bool32 dred_textbox_find_and_replace_all(dred_textbox* pTextBox, const char* text, const char* replacement);
+// Finds every occurance of the given string and replaces it with another. Returns the number of occurances that were replaced.
+size_t dred_textbox_find_and_replace_all(dred_textbox* pTextBox, const char* text, const char* replacement);
 
 
 // Shows the line numbers.
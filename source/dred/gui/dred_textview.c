@@ -1,5 +1,9 @@
 // Copyright (C) 2016 David Reid. See included LICENSE file.
 
+// The number of lines to wrap, and the number of milliseconds between each slice, when word wrapping in the background.
+#define DRED_TEXTVIEW_LAYOUT_STEP_LINE_COUNT       2048
+#define DRED_TEXTVIEW_LAYOUT_STEP_INTERVAL         10
+
 /// Retrieves the offset to draw the text in the text box.
 void dred_textview__get_text_offset(dred_textview* pTextView, float* pOffsetXOut, float* pOffsetYOut);
 
@@ -37,6 +41,9 @@ void dred_textview__on_paint_line_numbers(dred_control* pLineNumbers, dred_rect
 /// Refreshes the line number of the given text editor.
 void dred_textview__refresh_line_numbers(dred_textview* pTextView);
 
+/// Marks the line numbers as dirty if they would be drawn differently to last time.
+void dred_textview__dirty_line_numbers(dred_textview* pTextView);
+
 
 /// on_paint_rect()
 void dred_textview_engine__on_paint_rect(drte_engine* pLayout, drte_view* pView, drte_style_token styleToken, drte_rect rect, void* pPaintData);
@@ -47,6 +54,12 @@ void dred_textview_engine__on_paint_text(drte_engine* pTextEngine, drte_view* pV
 /// on_dirty()
 void dred_textview_engine__on_dirty(drte_engine* pTextEngine, drte_view* pView, drte_rect rect);
 
+/// on_scroll()
+dr_bool32 dred_textview_engine__on_scroll(drte_engine* pTextEngine, drte_view* pView, float offsetX, float offsetY);
+
+/// Starts the background word wrapping timer if there are lines waiting to be wrapped.
+void dred_textview__begin_layout_timer(dred_textview* pTextView);
+
 /// on_cursor_move()
 void dred_textview_engine__on_cursor_move(drte_engine* pTextEngine, drte_view* pView, size_t iCursor);
 
@@ -71,8 +84,7 @@ void dred_textview__on_vscroll(dred_scrollbar* pSBControl, int scrollPos)
     drte_view_set_inner_offset_y(pTextView->pView, -drte_view_get_line_pos_y(pTextView->pView, scrollPos));
     dred_textview__refresh_scrollbars(pTextView);
 
-    // The line numbers need to be redrawn.
-    dred_control_dirty(pTextView->pLineNumbers, dred_control_get_local_rect(pTextView->pLineNumbers));
+    dred_textview__dirty_line_numbers(pTextView);
 }
 
 void dred_textview__on_hscroll(dred_scrollbar* pSBControl, int scrollPos)
@@ -91,19 +103,19 @@ void dred_textview__refresh_style(dred_textview* pTextView)
     dred_gui_get_font_metrics(pTextView->defaultStyle.pFont, &fontMetrics);
 
     // Default.
-    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->defaultStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->defaultStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
 
     // Selection.
-    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->selectionStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->selectionStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
 
     // Active line.
-    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->activeLineStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->activeLineStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
 
     // Cursor.
-    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->cursorStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->cursorStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
 
     // Line numbers.
-    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->lineNumbersStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth));
+    drte_engine_register_style_token(pTextView->pTextEngine, (drte_style_token)&pTextView->lineNumbersStyle, drte_font_metrics_create(fontMetrics.ascent, fontMetrics.descent, fontMetrics.lineHeight, fontMetrics.spaceWidth, fontMetrics.isMonospace));
 }
 
 
@@ -336,6 +348,9 @@ dr_bool32 dred_textview_init(dred_textview* pTextView, dred_context* pDred, dred
 
     pTextView->pView->pUserData = pTextView;
 
+    // Word wrapping of large files is done in the background so that resizing stays responsive.
+    drte_view_enable_progressive_word_wrap(pTextView->pView);
+
     dred_textview__insert_cursor(pTextView, 0, 0);
 
 
@@ -429,6 +444,7 @@ dr_bool32 dred_textview_init(dred_textview* pTextView, dred_context* pDred, dred
     drte_engine_set_on_paint_rect(pTextView->pTextEngine, dred_textview_engine__on_paint_rect);
     drte_engine_set_on_paint_text(pTextView->pTextEngine, dred_textview_engine__on_paint_text);
     drte_engine_set_on_dirty(pTextView->pTextEngine, dred_textview_engine__on_dirty);
+    drte_engine_set_on_scroll(pTextView->pTextEngine, dred_textview_engine__on_scroll);
     drte_engine_set_on_cursor_move(pTextView->pTextEngine, dred_textview_engine__on_cursor_move);
     //drte_engine_set_on_text_changed(pTextView->pTextEngine, dred_textview_engine__on_text_changed);
     //drte_engine_set_on_undo_point_changed(pTextView->pTextEngine, dred_textview_engine__on_undo_point_changed);
@@ -492,6 +508,11 @@ void dred_textview_uninit(dred_textview* pTextView)
         pTextView->pCursors = NULL;
     }
 
+    if (pTextView->pLayoutTimer) {
+        dred_timer_delete(pTextView->pLayoutTimer);
+        pTextView->pLayoutTimer = NULL;
+    }
+
     if (pTextView->pView) {
         drte_view_delete(pTextView->pView);
         pTextView->pView = NULL;
@@ -805,6 +826,7 @@ void dred_textview_disable_word_wrap(dred_textview* pTextView)
 
     drte_view_disable_word_wrap(pTextView->pView);
     dred_textview__refresh_scrollbars(pTextView);
+    dred_textview__begin_layout_timer(pTextView);
 }
 
 dr_bool32 dred_textview_is_word_wrap_enabled(dred_textview* pTextView)
@@ -1014,12 +1036,7 @@ dr_bool32 dred_textview_insert_text_at_cursors_no_undo(dred_textview* pTextView,
         return DR_FALSE;
     }
 
-    dr_bool32 wasTextChanged = DR_FALSE;
-    for (size_t iCursor = 0; iCursor < pTextView->cursorCount; ++iCursor) {
-        wasTextChanged = drte_view_insert_text_at_cursor(pTextView->pView, iCursor, text) || wasTextChanged;
-    }
-
-    return wasTextChanged;
+    return drte_view_insert_text_at_cursors(pTextView->pView, text);
 }
 
 dr_bool32 dred_textview_insert_text_at_cursors(dred_textview* pTextView, const char* text)
@@ -1237,7 +1254,7 @@ dr_bool32 dred_textview_find_and_replace_next(dred_textview* pTextView, const ch
     return wasTextChanged;
 }
 
-dr_bool32 dred_textview_find_and_replace_all(dred_textview* pTextView, const char* text, const char* replacement)
+size_t dred_textview_find_and_replace_all(dred_textview* pTextView, const char* text, const char* replacement)
 {
     if (pTextView == NULL) {
         return 0;
@@ -1248,31 +1265,122 @@ dr_bool32 dred_textview_find_and_replace_all(dred_textview* pTextView, const cha
     int originalScrollPosX = dred_scrollbar_get_scroll_position(pTextView->pHorzScrollbar);
     int originalScrollPosY = dred_scrollbar_get_scroll_position(pTextView->pVertScrollbar);
 
-    dr_bool32 wasTextChanged = DR_FALSE;
+    size_t replacementCount = 0;
     drte_engine_prepare_undo_point(pTextView->pTextEngine);
     {
         drte_view_begin_dirty(pTextView->pView);
         {
             drte_view_deselect_all(pTextView->pView);
 
-            // It's important that we don't replace the replacement text. To handle this, we just move the cursor to the top of the text and find
-            // and replace every occurance without looping.
-            drte_view_move_cursor_to_start_of_text(pTextView->pView, drte_view_get_last_cursor(pTextView->pView));
+            // Every occurance is found before anything is replaced which means the replacement text is never matched. The replacements are
+            // applied in one batch so the text is only re-wrapped and repainted once.
+            replacementCount = drte_engine_find_and_replace_all(pTextView->pTextEngine, text, replacement);
+
+            // The cursor may have moved so we'll need to restore it.
+            size_t lineCharStart = 0;
+            size_t lineCharEnd = 0;
+            drte_view_get_line_character_range(pTextView->pView, NULL, originalCursorLine, &lineCharStart, &lineCharEnd);
+
+            size_t newCursorPos = lineCharStart + originalCursorPos;
+            if (newCursorPos > lineCharEnd) {
+                newCursorPos = lineCharEnd;
+            }
+            drte_view_move_cursor_to_character(pTextView->pView, drte_view_get_last_cursor(pTextView->pView), newCursorPos);
+        }
+        drte_view_end_dirty(pTextView->pView);
+    }
+    if (replacementCount > 0) { drte_engine_commit_undo_point(pTextView->pTextEngine); }
+
+
+    // The scroll positions may have moved so we'll need to restore them.
+    dred_scrollbar_scroll_to(pTextView->pHorzScrollbar, originalScrollPosX);
+    dred_scrollbar_scroll_to(pTextView->pVertScrollbar, originalScrollPosY);
+
+    return replacementCount;
+}
+
+dr_bool32 dred_textview_find_regex_and_select_next(dred_textview* pTextView, drte_regex* pRegex)
+{
+    if (pTextView == NULL) {
+        return DR_FALSE;
+    }
+
+    size_t selectionStart;
+    size_t selectionEnd;
+    if (drte_view_find_regex(pTextView->pView, pRegex, &selectionStart, &selectionEnd))
+    {
+        drte_view_select(pTextView->pView, selectionStart, selectionEnd);
+        drte_view_move_cursor_to_end_of_selection(pTextView->pView, drte_view_get_last_cursor(pTextView->pView));
+
+        return DR_TRUE;
+    }
+
+    return DR_FALSE;
+}
+
+dr_bool32 dred_textview_find_regex_and_replace_next(dred_textview* pTextView, drte_regex* pRegex, const char* replacement)
+{
+    if (pTextView == NULL) {
+        return DR_FALSE;
+    }
+
+    dr_bool32 wasTextChanged = DR_FALSE;
+    drte_engine_prepare_undo_point(pTextView->pTextEngine);
+    {
+        drte_view_begin_dirty(pTextView->pView);
+        {
+            drte_view_deselect_all(pTextView->pView);
 
             size_t selectionStart;
             size_t selectionEnd;
-            while (drte_view_find_next_no_loop(pTextView->pView, text, &selectionStart, &selectionEnd))
+            if (drte_view_find_regex(pTextView->pView, pRegex, &selectionStart, &selectionEnd))
             {
-                drte_view_select(pTextView->pView, selectionStart, selectionEnd);
-                drte_view_move_cursor_to_end_of_selection(pTextView->pView, drte_view_get_last_cursor(pTextView->pView));
+                // The replacement refers to the matched text so it needs to be expanded before the match is deleted.
+                size_t expandedLength = drte_engine_expand_regex_replacement(pTextView->pTextEngine, pRegex, selectionStart, selectionEnd, replacement, NULL, 0);
+                char* expanded = (char*)malloc(expandedLength + 1);
+                if (expanded != NULL) {
+                    drte_engine_expand_regex_replacement(pTextView->pTextEngine, pRegex, selectionStart, selectionEnd, replacement, expanded, expandedLength + 1);
 
-                wasTextChanged = dred_textview_delete_selected_text_no_undo(pTextView) || wasTextChanged;
-                wasTextChanged = drte_view_insert_text_at_cursor(pTextView->pView, drte_view_get_last_cursor(pTextView->pView), replacement) || wasTextChanged;
+                    drte_view_select(pTextView->pView, selectionStart, selectionEnd);
+                    drte_view_move_cursor_to_end_of_selection(pTextView->pView, drte_view_get_last_cursor(pTextView->pView));
+
+                    wasTextChanged = dred_textview_delete_selected_text_no_undo(pTextView) || wasTextChanged;
+                    wasTextChanged = drte_view_insert_text_at_cursor(pTextView->pView, drte_view_get_last_cursor(pTextView->pView), expanded) || wasTextChanged;
+
+                    free(expanded);
+                }
             }
+        }
+        drte_view_end_dirty(pTextView->pView);
+    }
+    if (wasTextChanged) { drte_engine_commit_undo_point(pTextView->pTextEngine); }
+
+    return wasTextChanged;
+}
+
+size_t dred_textview_find_regex_and_replace_all(dred_textview* pTextView, drte_regex* pRegex, const char* replacement)
+{
+    if (pTextView == NULL) {
+        return 0;
+    }
+
+    size_t originalCursorLine = drte_view_get_cursor_line(pTextView->pView, drte_view_get_last_cursor(pTextView->pView));
+    size_t originalCursorPos = drte_view_get_cursor_character(pTextView->pView, drte_view_get_last_cursor(pTextView->pView)) - drte_view_get_line_first_character(pTextView->pView, NULL, originalCursorLine);
+    int originalScrollPosX = dred_scrollbar_get_scroll_position(pTextView->pHorzScrollbar);
+    int originalScrollPosY = dred_scrollbar_get_scroll_position(pTextView->pVertScrollbar);
+
+    size_t replacementCount = 0;
+    drte_engine_prepare_undo_point(pTextView->pTextEngine);
+    {
+        drte_view_begin_dirty(pTextView->pView);
+        {
+            drte_view_deselect_all(pTextView->pView);
+
+            replacementCount = drte_engine_find_and_replace_all_regex(pTextView->pTextEngine, pRegex, replacement);
 
             // The cursor may have moved so we'll need to restore it.
-            size_t lineCharStart;
-            size_t lineCharEnd;
+            size_t lineCharStart = 0;
+            size_t lineCharEnd = 0;
             drte_view_get_line_character_range(pTextView->pView, NULL, originalCursorLine, &lineCharStart, &lineCharEnd);
 
             size_t newCursorPos = lineCharStart + originalCursorPos;
@@ -1283,14 +1391,14 @@ dr_bool32 dred_textview_find_and_replace_all(dred_textview* pTextView, const cha
         }
         drte_view_end_dirty(pTextView->pView);
     }
-    if (wasTextChanged) { drte_engine_commit_undo_point(pTextView->pTextEngine); }
+    if (replacementCount > 0) { drte_engine_commit_undo_point(pTextView->pTextEngine); }
 
 
     // The scroll positions may have moved so we'll need to restore them.
     dred_scrollbar_scroll_to(pTextView->pHorzScrollbar, originalScrollPosX);
     dred_scrollbar_scroll_to(pTextView->pVertScrollbar, originalScrollPosY);
 
-    return wasTextChanged;
+    return replacementCount;
 }
 
 
@@ -1469,6 +1577,7 @@ void dred_textview_set_tab_size_in_spaces(dred_textview* pTextView, unsigned int
     }
 
     drte_view_set_tab_size(pTextView->pView, tabSizeInSpaces);
+    dred_textview__begin_layout_timer(pTextView);
 }
 
 unsigned int dred_textview_get_tab_size_in_spaces(dred_textview* pTextView)
@@ -2405,6 +2514,23 @@ void dred_textview_engine__on_dirty(drte_engine* pTextEngine, drte_view* pView,
     dred_textview__get_text_offset(pTextView, &offsetX, &offsetY);
 
     dred_control_dirty(DRED_CONTROL(pTextView), dred_offset_rect(drte_rect_to_dred(rect), offsetX, offsetY));
+
+    // Re-wrapping the whole document is the only thing that leaves lines waiting to be wrapped, and it always repaints.
+    dred_textview__begin_layout_timer(pTextView);
+}
+
+dr_bool32 dred_textview_engine__on_scroll(drte_engine* pTextEngine, drte_view* pView, float offsetX, float offsetY)
+{
+    (void)pTextEngine;
+
+    dred_textview* pTextView = (dred_textview*)pView->pUserData;
+    if (pTextView == NULL) {
+        return DR_FALSE;
+    }
+
+    // The text is clipped to the text rectangle when it's painted so that's the only part that needs to be moved. The text engine
+    // takes care of dirtying the strip that has been scrolled into view.
+    return dred_control_scroll_pixels(DRED_CONTROL(pTextView), dred_textview__get_text_rect(pTextView), offsetX, offsetY);
 }
 
 void dred_textview_engine__on_cursor_move(drte_engine* pTextEngine, drte_view* pView, size_t iCursor)
@@ -2460,9 +2586,8 @@ void dred_textview__on_text_changed(dred_textview* pTextView)
     // Scrollbars need to be refreshed whenever text is changed.
     dred_textview__refresh_scrollbars(pTextView);
 
-    // The line numbers need to be redrawn.
-    // TODO: This can probably be optimized a bit so that it is only redrawn if a line was inserted or deleted.
-    dred_control_dirty(pTextView->pLineNumbers, dred_control_get_local_rect(pTextView->pLineNumbers));
+    // The line numbers only need to be redrawn if a line was inserted or deleted.
+    dred_textview__dirty_line_numbers(pTextView);
 }
 
 size_t dred_textview__on_get_undo_state(dred_textview* pTextView, void* pDataOut)
@@ -2541,6 +2666,53 @@ void dred_textview__on_timer(dred_timer* pTimer, void* pUserData)
     dred_textview_step(pTextView, 100);
 }
 
+void dred_textview__on_layout_timer(dred_timer* pTimer, void* pUserData)
+{
+    (void)pTimer;
+
+    dred_textview* pTextView = (dred_textview*)pUserData;
+    assert(pTextView != NULL);
+
+    // Wrapping lines above the top of the view moves the inner offset so that the visible text stays where it is. The scrollbar
+    // needs to be moved to match.
+    float innerOffsetY = drte_view_get_inner_offset_y(pTextView->pView);
+
+    dr_bool32 isLayoutInProgress = drte_view_step_word_wrapping(pTextView->pView, DRED_TEXTVIEW_LAYOUT_STEP_LINE_COUNT);
+
+    // The lines are measured for the horizontal scrollbar when word wrap is disabled.
+    if (drte_view_step_line_measuring(pTextView->pView, DRED_TEXTVIEW_LAYOUT_STEP_LINE_COUNT)) {
+        isLayoutInProgress = DR_TRUE;
+    }
+
+    dred_textview__refresh_scrollbar_ranges(pTextView);
+    if (innerOffsetY != drte_view_get_inner_offset_y(pTextView->pView)) {
+        size_t iFirstVisibleLine;
+        drte_view_get_visible_lines(pTextView->pView, &iFirstVisibleLine, NULL);
+        dred_scrollbar_scroll_to(pTextView->pVertScrollbar, (int)iFirstVisibleLine);
+    }
+
+    dred_textview__dirty_line_numbers(pTextView);
+
+    // The timer is deleted from inside it's own callback which is fine because nothing touches it after this returns.
+    if (!isLayoutInProgress) {
+        dred_timer_delete(pTextView->pLayoutTimer);
+        pTextView->pLayoutTimer = NULL;
+    }
+}
+
+void dred_textview__begin_layout_timer(dred_textview* pTextView)
+{
+    assert(pTextView != NULL);
+
+    if (pTextView->pLayoutTimer != NULL) {
+        return;
+    }
+
+    if (drte_view_is_word_wrap_in_progress(pTextView->pView) || drte_view_is_line_measuring_in_progress(pTextView->pView)) {
+        pTextView->pLayoutTimer = dred_timer_create(DRED_TEXTVIEW_LAYOUT_STEP_INTERVAL, dred_textview__on_layout_timer, pTextView);
+    }
+}
+
 void dred_textview_on_capture_keyboard(dred_control* pControl, dred_control* pPrevCapturedControl)
 {
     (void)pPrevCapturedControl;
@@ -2685,7 +2857,7 @@ void dred_textview__refresh_horizontal_scrollbar(dred_textview* pTextView)
 {
     assert(pTextView != NULL);
 
-    float textWidth = drte_view_get_visible_line_width(pTextView->pView);
+    float textWidth = drte_view_get_max_line_width(pTextView->pView);
     float containerWidth;
     drte_view_get_size(pTextView->pView, &containerWidth, NULL);
     dred_scrollbar_set_range_and_page_size(pTextView->pHorzScrollbar, 0, (int)textWidth, (int)containerWidth);
@@ -2707,8 +2879,9 @@ void dred_textview__refresh_scrollbar_ranges(dred_textview* pTextView)
 {
     assert(pTextView != NULL);
 
-    // The vertical scrollbar is based on the line count.
-    size_t lineCount = drte_view_get_line_count(pTextView->pView);
+    // The vertical scrollbar is based on the line count. While word wrapping is being done in the background we only have an
+    // estimate of the final line count.
+    size_t lineCount = drte_view_get_estimated_line_count(pTextView->pView);
     size_t pageSize  = drte_view_get_visible_line_count(pTextView->pView);
 
     size_t extraScroll = 0;
@@ -2927,6 +3100,23 @@ void dred_textview__on_paint_text_line_numbers(drte_engine* pEngine, drte_view*
     dred_control_draw_text(pTextView->pLineNumbers, pStyleFG->pFont, text, (int)textLength, posX + offsetX, posY + offsetY, pStyleFG->fgColor, pStyleBG->bgColor, pPaintData);
 }
 
+void dred_textview__dirty_line_numbers(dred_textview* pTextView)
+{
+    assert(pTextView != NULL);
+
+    // Without word wrap the line numbers only depend on which line is at the top and how many lines there are. With word wrap they
+    // also depend on how the visible lines are wrapped, so they're always redrawn.
+    float innerOffsetY = drte_view_get_inner_offset_y(pTextView->pView);
+    size_t lineCount = drte_view_get_line_count(pTextView->pView);
+    if (!drte_view_is_word_wrap_enabled(pTextView->pView) && pTextView->lineNumbersInnerOffsetY == innerOffsetY && pTextView->lineNumbersLineCount == lineCount) {
+        return;
+    }
+
+    pTextView->lineNumbersInnerOffsetY = innerOffsetY;
+    pTextView->lineNumbersLineCount = lineCount;
+    dred_control_dirty(pTextView->pLineNumbers, dred_control_get_local_rect(pTextView->pLineNumbers));
+}
+
 void dred_textview__on_paint_line_numbers(dred_control* pLineNumbers, dred_rect relativeRect, void* pPaintData)
 {
     (void)relativeRect;
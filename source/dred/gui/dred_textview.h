@@ -73,6 +73,11 @@ struct dred_textview
     /// The padding to the right of the line numbers.
     float lineNumbersPaddingRight;
 
+    // The inner offset and line count of the view when the line numbers were last marked as dirty. Whatever was drawn last is left
+    // as-is until one of these changes.
+    float lineNumbersInnerOffsetY;
+    size_t lineNumbersLineCount;
+
 
     /// The desired width of the vertical scrollbar.
     float vertScrollbarSize;
@@ -136,6 +141,9 @@ struct dred_textview
 
     // The timer for stepping the cursor.
     dred_timer* pTimer;
+
+    // The timer for wrapping and measuring lines in the background. This only exists while either of those are in progress.
+    dred_timer* pLayoutTimer;
 };
 
 
@@ -343,8 +351,17 @@ dr_bool32 dred_textview_find_and_select_next(dred_textview* pTextView, const cha
 // Finds the next occurance of the given string and replaces it with another.
 dr_bool32 dred_textview_find_and_replace_next(dred_textview* pTextView, const char* text, const char* replacement);
 
-// Finds every occurance of the given string and replaces it with another.
-dr_bool32 dred_textview_find_and_replace_all(dred_textview* pTextView, const char* text, const char* replacement);
+// Finds every occurance of the given string and replaces it with another. Returns the number of occurances that were replaced.
+size_t dred_textview_find_and_replace_all(dred_textview* pTextView, const char* text, const char* replacement);
+
+// Finds and selects the next match of the given regular expression, starting from the cursor and looping back to the start.
+dr_bool32 dred_textview_find_regex_and_select_next(dred_textview* pTextView, drte_regex* pRegex);
+
+// Finds the next match of the given regular expression and replaces it. The replacement can refer to groups with \1 to \9.
+dr_bool32 dred_textview_find_regex_and_replace_next(dred_textview* pTextView, drte_regex* pRegex, const char* replacement);
+
+// Finds every match of the given regular expression and replaces it. Returns the number of matches that were replaced.
+size_t dred_textview_find_regex_and_replace_all(dred_textview* pTextView, drte_regex* pRegex, const char* replacement);
 
 
 // Shows the line numbers.
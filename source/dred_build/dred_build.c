@@ -47,6 +47,57 @@ typedef struct
     unsigned int baseHeight;
 } stock_image;
 
+typedef struct
+{
+    char word[256];
+    char category[256];
+    uint64_t hash;
+} keyword;
+
+typedef struct
+{
+    char open[64];
+    char close[64];         // Empty for line comments, which are closed by the end of the line.
+    char escape;            // The character that escapes the one after it, or 0 if there isn't one.
+    dr_bool32 isMultiLine;
+    dr_bool32 isNested;
+    dr_bool32 isWordStart;  // Whether or not the rule can only be opened at the start of a word.
+    int nestingDepth;       // The number of levels of nesting that are tracked. Only used when isNested is true.
+    const char* category;
+} lexer_rule;
+
+typedef struct
+{
+    char** ppExtensions;
+    lexer_rule* pRules;
+    keyword* pKeywords;
+    dr_bool32 hasNumbers;
+} language;
+
+typedef struct
+{
+    uint8_t lo;
+    uint8_t hi;
+    int target;
+} lexer_nfa_edge;
+
+typedef struct
+{
+    lexer_nfa_edge* pEdges;
+    int priority;           // -1 if a token can't end in this state.
+    const char* category;
+    uint8_t flags;
+} lexer_nfa_state;
+
+typedef struct
+{
+    int* pNFASet;           // Sorted.
+    int transitions[256];   // -1 if there is no transition.
+    int priority;
+    const char* category;
+    uint8_t flags;
+} lexer_dfa_state;
+
 
 
 #include "dred_build_website.c"
@@ -67,6 +118,17 @@ double g_StockImageScales[] = {1.0, 1.5, 2.0};
 #define CONFIG_VAR_TYPE_IMAGE       6
 #define CONFIG_VAR_TYPE_COLOR       7
 
+// These must match the ones in dred_highlighters.h.
+#define LEXER_DEAD_STATE            0xFFFF
+#define LEXER_ACCEPT_BIT            0x8000
+#define LEXER_STATE_IDENTIFIER      (1 << 0)
+#define LEXER_STATE_CONTINUES       (1 << 1)
+
+// The number of levels a nested comment is tracked to when the language doesn't give a depth, and the most it can give. Opening a
+// comment past its depth is ignored, so the comment ends early by however many levels were ignored.
+#define LEXER_DEFAULT_NESTING_DEPTH 8
+#define LEXER_MAX_NESTING_DEPTH     32
+
 const char* config_var_type_to_string(unsigned int type)
 {
     if (type == CONFIG_VAR_TYPE_INTEGER) {
@@ -842,6 +904,845 @@ void generate_config_vars(FILE* pFileOut, FILE* pFileOutH)
     fwrite_string(pFileOut, funcOutput);
 }
 
+// The hash of a keyword. This must match dred_highlighter__hash().
+uint64_t keyword_hash(const char* text, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// The slot of a keyword in a keyword table. This must match dred_highlighter__get_keyword_slot().
+unsigned int keyword_slot(uint64_t hash, uint16_t displacement, unsigned int keywordCount)
+{
+    uint32_t x = (uint32_t)hash ^ displacement;
+    x ^= x >> 16;
+    x *= 0x85EBCA6B;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35;
+    x ^= x >> 16;
+
+    return x % keywordCount;
+}
+
+// Finds a displacement for each bucket that moves every keyword in it to a free slot. The biggest buckets are placed first while most
+// slots are still free. On success pSlots will hold the index of the keyword in each slot. Returns DR_FALSE if there's a bucket whose
+// keywords can't be separated, in which case a different bucket count needs to be tried.
+dr_bool32 build_keyword_table(keyword* pKeywords, unsigned int keywordCount, unsigned int bucketCount, uint16_t* pDisplacements, int* pSlots)
+{
+    unsigned int* pBucketSizes = (unsigned int*)calloc(bucketCount, sizeof(*pBucketSizes));
+    unsigned int maxBucketSize = 0;
+    for (unsigned int iKeyword = 0; iKeyword < keywordCount; ++iKeyword) {
+        unsigned int iBucket = (uint32_t)(pKeywords[iKeyword].hash >> 32) % bucketCount;
+        pBucketSizes[iBucket] += 1;
+        if (maxBucketSize < pBucketSizes[iBucket]) {
+            maxBucketSize = pBucketSizes[iBucket];
+        }
+    }
+
+    for (unsigned int iSlot = 0; iSlot < keywordCount; ++iSlot) {
+        pSlots[iSlot] = -1;
+    }
+
+    unsigned int* pBucketKeywords = (unsigned int*)malloc(maxBucketSize * sizeof(*pBucketKeywords));
+    unsigned int* pBucketSlots = (unsigned int*)malloc(maxBucketSize * sizeof(*pBucketSlots));
+
+    dr_bool32 result = DR_TRUE;
+    for (unsigned int bucketSize = maxBucketSize; bucketSize > 0 && result; --bucketSize) {
+        for (unsigned int iBucket = 0; iBucket < bucketCount && result; ++iBucket) {
+            if (pBucketSizes[iBucket] != bucketSize) {
+                continue;
+            }
+
+            unsigned int count = 0;
+            for (unsigned int iKeyword = 0; iKeyword < keywordCount; ++iKeyword) {
+                if ((uint32_t)(pKeywords[iKeyword].hash >> 32) % bucketCount == iBucket) {
+                    pBucketKeywords[count++] = iKeyword;
+                }
+            }
+
+            result = DR_FALSE;
+            for (unsigned int displacement = 0; displacement <= 0xFFFF && !result; ++displacement) {
+                result = DR_TRUE;
+                for (unsigned int i = 0; i < count && result; ++i) {
+                    pBucketSlots[i] = keyword_slot(pKeywords[pBucketKeywords[i]].hash, (uint16_t)displacement, keywordCount);
+                    if (pSlots[pBucketSlots[i]] != -1) {
+                        result = DR_FALSE;
+                    }
+                    for (unsigned int j = 0; j < i && result; ++j) {
+                        if (pBucketSlots[j] == pBucketSlots[i]) {
+                            result = DR_FALSE;
+                        }
+                    }
+                }
+
+                if (result) {
+                    pDisplacements[iBucket] = (uint16_t)displacement;
+                    for (unsigned int i = 0; i < count; ++i) {
+                        pSlots[pBucketSlots[i]] = (int)pBucketKeywords[i];
+                    }
+                }
+            }
+        }
+    }
+
+    free(pBucketSizes);
+    free(pBucketKeywords);
+    free(pBucketSlots);
+    return result;
+}
+
+void generate_keyword_table(FILE* pFileOut, const char* filename, keyword* pKeywords, const char* tableName)
+{
+    assert(pFileOut != NULL);
+    assert(filename != NULL);
+    assert(tableName != NULL);
+
+    char line[4096];
+
+    unsigned int keywordCount = (unsigned int)stb_sb_count(pKeywords);
+    if (keywordCount == 0) {
+        snprintf(line, sizeof(line), "dred_highlight_keyword_table %s = {NULL, 0, NULL, 0};\n\n", tableName);
+        fwrite_string(pFileOut, line);
+        return;
+    }
+
+    // Two keywords to a bucket keeps the table small. If that can't be made to work there's more room to move things around with more
+    // buckets.
+    uint16_t* pDisplacements = NULL;
+    int* pSlots = (int*)malloc(keywordCount * sizeof(*pSlots));
+    unsigned int bucketCount;
+    for (bucketCount = keywordCount/2 + 1; bucketCount <= keywordCount*4; ++bucketCount) {
+        pDisplacements = (uint16_t*)realloc(pDisplacements, bucketCount * sizeof(*pDisplacements));
+        memset(pDisplacements, 0, bucketCount * sizeof(*pDisplacements));
+        if (build_keyword_table(pKeywords, keywordCount, bucketCount, pDisplacements, pSlots)) {
+            break;
+        }
+    }
+
+    if (bucketCount > keywordCount*4) {
+        printf("%s: Failed to build keyword table.\n", filename);
+        free(pDisplacements);
+        free(pSlots);
+        return;
+    }
+
+
+    char* keywordsOutput = gb_make_string("");
+    snprintf(line, sizeof(line), "dred_highlight_keyword %s_Keywords[] = {\n", tableName);
+    keywordsOutput = gb_append_cstring(keywordsOutput, line);
+    for (unsigned int iSlot = 0; iSlot < keywordCount; ++iSlot) {
+        keyword* pKeyword = &pKeywords[pSlots[iSlot]];
+        snprintf(line, sizeof(line), "    {\"%s\", %d, dred_highlight_category_%s},\n", pKeyword->word, (int)strlen(pKeyword->word), pKeyword->category);
+        keywordsOutput = gb_append_cstring(keywordsOutput, line);
+    }
+    keywordsOutput = gb_append_cstring(keywordsOutput, "};\n\n");
+
+    snprintf(line, sizeof(line), "uint16_t %s_Displacements[] = {", tableName);
+    keywordsOutput = gb_append_cstring(keywordsOutput, line);
+    for (unsigned int iBucket = 0; iBucket < bucketCount; ++iBucket) {
+        snprintf(line, sizeof(line), "%s%d,", (iBucket % 16 == 0) ? "\n    " : " ", pDisplacements[iBucket]);
+        keywordsOutput = gb_append_cstring(keywordsOutput, line);
+    }
+    keywordsOutput = gb_append_cstring(keywordsOutput, "\n};\n\n");
+
+    snprintf(line, sizeof(line), "dred_highlight_keyword_table %s = {%s_Keywords, %d, %s_Displacements, %d};\n\n", tableName, tableName, keywordCount, tableName, bucketCount);
+    keywordsOutput = gb_append_cstring(keywordsOutput, line);
+
+    fwrite_string(pFileOut, keywordsOutput);
+    gb_free_string(keywordsOutput);
+
+    free(pDisplacements);
+    free(pSlots);
+}
+
+// Reads a language definition file. See resources/languages/c.txt for the format. Returns DR_FALSE if the file can't be opened or if
+// it asks for something the lexer can't do, in which case the build should fail rather than highlight the language wrongly.
+dr_bool32 parse_language(const char* filename, language* pLanguage)
+{
+    assert(filename != NULL);
+    assert(pLanguage != NULL);
+
+    char filePath[256];
+    drpath_copy_and_append(filePath, sizeof(filePath), "../../../resources/languages", filename);
+
+    size_t fileDataSize;
+    char* fileData = dr_open_and_read_text_file(filePath, &fileDataSize);
+    if (fileData == NULL) {
+        printf("Failed to open language file: %s\n", filePath);
+        return DR_FALSE;
+    }
+
+    dr_bool32 result = DR_TRUE;
+
+    char line[4096];
+    const char* nextLine = fileData;
+    while (nextLine != NULL) {
+        if (dr_copy_line(nextLine, line, sizeof(line)) == 0 || (line[0] == '/' && line[1] == '/')) {
+            nextLine = dr_next_line(nextLine);
+            continue;
+        }
+
+        char directive[256];
+        const char* next = dr_next_token(line, directive, sizeof(directive));
+        if (next == NULL) {
+            nextLine = dr_next_line(nextLine);
+            continue;
+        }
+
+        if (strcmp(directive, "extensions") == 0) {
+            char extension[256];
+            while ((next = dr_next_token(next, extension, sizeof(extension))) != NULL) {
+                char* pExtension = (char*)malloc(strlen(extension) + 1);
+                strcpy_s(pExtension, strlen(extension) + 1, extension);
+                stb_sb_push(pLanguage->ppExtensions, pExtension);
+            }
+        } else if (strcmp(directive, "number") == 0) {
+            pLanguage->hasNumbers = DR_TRUE;
+        } else if (strcmp(directive, "line_comment") == 0 || strcmp(directive, "block_comment") == 0 || strcmp(directive, "string") == 0 || strcmp(directive, "raw_string") == 0) {
+            lexer_rule rule;
+            memset(&rule, 0, sizeof(rule));
+
+            char option[256];
+            next = dr_next_token(next, rule.open, sizeof(rule.open));
+            if (strcmp(directive, "line_comment") == 0) {
+                rule.category = "comment";
+            } else if (strcmp(directive, "block_comment") == 0) {
+                rule.category = "comment";
+                rule.isMultiLine = DR_TRUE;
+                next = dr_next_token(next, rule.close, sizeof(rule.close));
+            } else if (strcmp(directive, "raw_string") == 0) {
+                rule.category = "string";
+                next = dr_next_token(next, rule.close, sizeof(rule.close));
+            } else {
+                // Strings are closed by the same delimiter they are opened with.
+                rule.category = "string";
+                strcpy_s(rule.close, sizeof(rule.close), rule.open);
+                next = dr_next_token(next, option, sizeof(option));
+                if (next != NULL && strcmp(option, "none") != 0) {
+                    rule.escape = option[0];
+                }
+            }
+
+            while ((next = dr_next_token(next, option, sizeof(option))) != NULL) {
+                if (strcmp(option, "nested") == 0) {
+                    rule.isNested = DR_TRUE;
+                    rule.nestingDepth = LEXER_DEFAULT_NESTING_DEPTH;
+
+                    // The depth is optional.
+                    char depth[256];
+                    const char* nextAfterDepth = dr_next_token(next, depth, sizeof(depth));
+                    if (nextAfterDepth != NULL && depth[0] >= '0' && depth[0] <= '9') {
+                        next = nextAfterDepth;
+                        rule.nestingDepth = atoi(depth);
+                        if (rule.nestingDepth < 1 || rule.nestingDepth > LEXER_MAX_NESTING_DEPTH) {
+                            printf("%s: Nesting depth must be between 1 and %d: %s\n", filename, LEXER_MAX_NESTING_DEPTH, line);
+                            result = DR_FALSE;
+                        }
+                    }
+                } else if (strcmp(option, "multiline") == 0) {
+                    rule.isMultiLine = DR_TRUE;
+                } else if (strcmp(option, "word_start") == 0) {
+                    rule.isWordStart = DR_TRUE;
+                } else {
+                    printf("%s: Unknown option: %s\n", filename, option);
+                }
+            }
+
+            if (rule.open[0] == '\0' || (strcmp(directive, "line_comment") != 0 && rule.close[0] == '\0')) {
+                printf("%s: Missing delimiter: %s\n", filename, line);
+            } else {
+                stb_sb_push(pLanguage->pRules, rule);
+            }
+        } else {
+            // Anything else is a keyword category followed by the keywords in it.
+            keyword kw;
+            strcpy_s(kw.category, sizeof(kw.category), directive);
+            while ((next = dr_next_token(next, kw.word, sizeof(kw.word))) != NULL) {
+                kw.hash = keyword_hash(kw.word, strlen(kw.word));
+
+                dr_bool32 exists = DR_FALSE;
+                for (int iKeyword = 0; iKeyword < stb_sb_count(pLanguage->pKeywords); ++iKeyword) {
+                    if (strcmp(pLanguage->pKeywords[iKeyword].word, kw.word) == 0) {
+                        printf("%s: Duplicate keyword: %s\n", filename, kw.word);
+                        exists = DR_TRUE;
+                        break;
+                    }
+                    if (pLanguage->pKeywords[iKeyword].hash == kw.hash) {
+                        printf("%s: Keywords have the same hash: %s and %s\n", filename, pLanguage->pKeywords[iKeyword].word, kw.word);
+                        exists = DR_TRUE;
+                        break;
+                    }
+                }
+
+                if (!exists) {
+                    stb_sb_push(pLanguage->pKeywords, kw);
+                }
+            }
+        }
+
+        nextLine = dr_next_line(nextLine);
+    }
+
+    dr_free_file_data(fileData);
+    return result;
+}
+
+int lexer_add_nfa_state(lexer_nfa_state** ppStates, int priority, const char* category, uint8_t flags)
+{
+    lexer_nfa_state state;
+    state.pEdges = NULL;
+    state.priority = priority;
+    state.category = category;
+    state.flags = flags;
+    stb_sb_push(*ppStates, state);
+
+    return stb_sb_count(*ppStates) - 1;
+}
+
+void lexer_add_nfa_edge(lexer_nfa_state* pStates, int iState, unsigned int lo, unsigned int hi, int iTarget)
+{
+    lexer_nfa_edge edge;
+    edge.lo = (uint8_t)lo;
+    edge.hi = (uint8_t)hi;
+    edge.target = iTarget;
+    stb_sb_push(pStates[iState].pEdges, edge);
+}
+
+// Retrieves the index of the longest prefix of a delimiter that the given text ends with. Prefixes are the partial matches of the
+// delimiters of a rule that are tracked while inside it. The text is not null terminated since it can contain any character.
+int lexer_find_longest_prefix(char** ppPrefixes, const char* text, size_t textLength)
+{
+    int iLongest = 0;
+    for (int iPrefix = 0; iPrefix < stb_sb_count(ppPrefixes); ++iPrefix) {
+        size_t prefixLength = strlen(ppPrefixes[iPrefix]);
+        if (prefixLength <= textLength && memcmp(text + textLength - prefixLength, ppPrefixes[iPrefix], prefixLength) == 0 && prefixLength > strlen(ppPrefixes[iLongest])) {
+            iLongest = iPrefix;
+        }
+    }
+
+    return iLongest;
+}
+
+dr_bool32 lexer_ends_with(const char* text, size_t textLength, const char* delimiter)
+{
+    size_t delimiterLength = strlen(delimiter);
+    return delimiterLength > 0 && delimiterLength <= textLength && memcmp(text + textLength - delimiterLength, delimiter, delimiterLength) == 0;
+}
+
+// Adds the states for the inside of a rule and returns the state it starts in. Inside a rule we keep track of how much of a delimiter
+// has been seen so far, whether or not the last character was an escape, and how deep it's nested. Every one of these states accepts
+// since a comment or string that runs to the end of the line is still a comment or string. Each level of nesting needs its own copy
+// of the states, which is why the depth is limited.
+int lexer_add_rule_states(lexer_nfa_state** ppStates, lexer_rule* pRule, int priority)
+{
+    char** ppPrefixes = NULL;
+    stb_sb_push(ppPrefixes, (char*)calloc(1, 1));
+
+    const char* delimiters[2] = {pRule->close, pRule->isNested ? pRule->open : ""};
+    for (int iDelimiter = 0; iDelimiter < 2; ++iDelimiter) {
+        for (size_t length = 1; length < strlen(delimiters[iDelimiter]); ++length) {
+            dr_bool32 exists = DR_FALSE;
+            for (int iPrefix = 0; iPrefix < stb_sb_count(ppPrefixes); ++iPrefix) {
+                if (strlen(ppPrefixes[iPrefix]) == length && strncmp(ppPrefixes[iPrefix], delimiters[iDelimiter], length) == 0) {
+                    exists = DR_TRUE;
+                }
+            }
+
+            if (!exists) {
+                char* pPrefix = (char*)malloc(length + 1);
+                strncpy_s(pPrefix, length + 1, delimiters[iDelimiter], length);
+                stb_sb_push(ppPrefixes, pPrefix);
+            }
+        }
+    }
+
+    int prefixCount = stb_sb_count(ppPrefixes);
+    int escapeCount = (pRule->escape != '\0') ? 2 : 1;
+    int depthCount  = pRule->isNested ? pRule->nestingDepth : 1;
+    uint8_t flags   = pRule->isMultiLine ? LEXER_STATE_CONTINUES : 0;
+
+    int iFirstState = stb_sb_count(*ppStates);
+    for (int iState = 0; iState < depthCount*escapeCount*prefixCount; ++iState) {
+        lexer_add_nfa_state(ppStates, priority, pRule->category, flags);
+    }
+
+    // Once the rule is closed nothing else can be added to the token.
+    int iClosedState = lexer_add_nfa_state(ppStates, priority, pRule->category, 0);
+
+    for (int depth = 0; depth < depthCount; ++depth) {
+        for (int isEscaped = 0; isEscaped < escapeCount; ++isEscaped) {
+            for (int iPrefix = 0; iPrefix < prefixCount; ++iPrefix) {
+                int iState = iFirstState + (depth*escapeCount + isEscaped)*prefixCount + iPrefix;
+                for (unsigned int c = 0; c < 256; ++c) {
+                    int iTarget;
+                    if (isEscaped) {
+                        iTarget = iFirstState + (depth*escapeCount)*prefixCount;
+                    } else if (c == '\n' && !pRule->isMultiLine) {
+                        continue;
+                    } else if (pRule->escape != '\0' && c == (unsigned char)pRule->escape) {
+                        iTarget = iFirstState + (depth*escapeCount + 1)*prefixCount;
+                    } else {
+                        char text[sizeof(pRule->open) + sizeof(pRule->close)];
+                        size_t textLength = strlen(ppPrefixes[iPrefix]);
+                        memcpy(text, ppPrefixes[iPrefix], textLength);
+                        text[textLength++] = (char)c;
+
+                        if (lexer_ends_with(text, textLength, pRule->close)) {
+                            iTarget = (depth == 0) ? iClosedState : iFirstState + ((depth-1)*escapeCount)*prefixCount;
+                        } else if (pRule->isNested && lexer_ends_with(text, textLength, pRule->open)) {
+                            iTarget = iFirstState + (dr_min(depth+1, depthCount-1)*escapeCount)*prefixCount;
+                        } else {
+                            iTarget = iFirstState + (depth*escapeCount)*prefixCount + lexer_find_longest_prefix(ppPrefixes, text, textLength);
+                        }
+                    }
+
+                    // Runs of characters going to the same state are merged into a single edge.
+                    lexer_nfa_state* pState = &(*ppStates)[iState];
+                    int edgeCount = stb_sb_count(pState->pEdges);
+                    if (edgeCount > 0 && pState->pEdges[edgeCount-1].hi == c-1 && pState->pEdges[edgeCount-1].target == iTarget) {
+                        pState->pEdges[edgeCount-1].hi = (uint8_t)c;
+                    } else {
+                        lexer_add_nfa_edge(*ppStates, iState, c, c, iTarget);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int iPrefix = 0; iPrefix < prefixCount; ++iPrefix) {
+        free(ppPrefixes[iPrefix]);
+    }
+    stb_sb_free(ppPrefixes);
+
+    return iFirstState;
+}
+
+// Whether or not a character separates words, for rules that can only be opened at the start of a word. These are the characters that
+// separate words in shell scripts.
+dr_bool32 lexer_is_word_break(unsigned int c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f' || (c != 0 && strchr(";&|()<>", (int)c) != NULL);
+}
+
+// Builds the NFA of a language. State 0 is where every token starts. The highest priority state wins when more than one accepts the
+// same token.
+lexer_nfa_state* lexer_build_nfa(language* pLanguage)
+{
+    lexer_nfa_state* pStates = NULL;
+    int iStart = lexer_add_nfa_state(&pStates, -1, "default", 0);
+
+    // Any character can be a token by itself so that lexing always moves forward.
+    int iChar = lexer_add_nfa_state(&pStates, 0, "default", 0);
+    lexer_add_nfa_edge(pStates, iStart, 0, 255, iChar);
+
+    // Runs of characters that can't start anything, such as white space and most punctuation, are lexed as a single token. They are
+    // never highlighted, but lexing them one at a time would be most of the work of lexing a file.
+    //
+    // When a rule can only be opened at the start of a word, plain runs that end in the middle of a word are lexed with a state of their
+    // own so that the rule's opening character can be taken as part of the run.
+    dr_bool32 hasWordStartRules = DR_FALSE;
+    for (int iRule = 0; iRule < stb_sb_count(pLanguage->pRules); ++iRule) {
+        if (pLanguage->pRules[iRule].isWordStart) {
+            hasWordStartRules = DR_TRUE;
+        }
+    }
+
+    int iPlain = lexer_add_nfa_state(&pStates, 0, "default", 0);
+    int iPlainInWord = hasWordStartRules ? lexer_add_nfa_state(&pStates, 0, "default", 0) : iPlain;
+    for (unsigned int c = 0; c < 256; ++c) {
+        dr_bool32 isPlain = !((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_');
+        for (int iRule = 0; iRule < stb_sb_count(pLanguage->pRules); ++iRule) {
+            if (c == (unsigned char)pLanguage->pRules[iRule].open[0]) {
+                isPlain = DR_FALSE;
+            }
+        }
+
+        if (isPlain) {
+            int iNext = lexer_is_word_break(c) ? iPlain : iPlainInWord;
+            lexer_add_nfa_edge(pStates, iStart, c, c, iNext);
+            lexer_add_nfa_edge(pStates, iPlain, c, c, iNext);
+            if (iPlainInWord != iPlain) {
+                lexer_add_nfa_edge(pStates, iPlainInWord, c, c, iNext);
+            }
+        }
+    }
+
+    // Numbers take the identifier characters that follow them so that the "f" in "1.0f" isn't mistaken for an identifier.
+    int iNumber = -1;
+    if (pLanguage->hasNumbers) {
+        iNumber = lexer_add_nfa_state(&pStates, 1, "default", 0);
+        lexer_add_nfa_edge(pStates, iStart, '0', '9', iNumber);
+        lexer_add_nfa_edge(pStates, iNumber, '0', '9', iNumber);
+        lexer_add_nfa_edge(pStates, iNumber, 'A', 'Z', iNumber);
+        lexer_add_nfa_edge(pStates, iNumber, 'a', 'z', iNumber);
+        lexer_add_nfa_edge(pStates, iNumber, '_', '_', iNumber);
+    } else if (iPlainInWord != iPlain) {
+        // Digits are otherwise lexed one at a time, which would leave the "#" in "1#2" at the start of a token.
+        lexer_add_nfa_edge(pStates, iStart, '0', '9', iPlainInWord);
+        lexer_add_nfa_edge(pStates, iPlainInWord, '0', '9', iPlainInWord);
+    }
+
+    int iIdentifier = lexer_add_nfa_state(&pStates, 2, "default", LEXER_STATE_IDENTIFIER);
+    lexer_add_nfa_edge(pStates, iStart, 'A', 'Z', iIdentifier);
+    lexer_add_nfa_edge(pStates, iStart, 'a', 'z', iIdentifier);
+    lexer_add_nfa_edge(pStates, iStart, '_', '_', iIdentifier);
+    lexer_add_nfa_edge(pStates, iIdentifier, '0', '9', iIdentifier);
+    lexer_add_nfa_edge(pStates, iIdentifier, 'A', 'Z', iIdentifier);
+    lexer_add_nfa_edge(pStates, iIdentifier, 'a', 'z', iIdentifier);
+    lexer_add_nfa_edge(pStates, iIdentifier, '_', '_', iIdentifier);
+
+    // Rules that are defined first take priority over later ones.
+    for (int iRule = 0; iRule < stb_sb_count(pLanguage->pRules); ++iRule) {
+        lexer_rule* pRule = &pLanguage->pRules[iRule];
+
+        // In the middle of a word the opening character continues the word instead, as with the "#" in "$#" and "x=foo#bar" in shell
+        // scripts.
+        if (pRule->isWordStart) {
+            unsigned char c = (unsigned char)pRule->open[0];
+            lexer_add_nfa_edge(pStates, iPlainInWord, c, c, iPlainInWord);
+            lexer_add_nfa_edge(pStates, iIdentifier, c, c, iPlainInWord);
+            if (iNumber != -1) {
+                lexer_add_nfa_edge(pStates, iNumber, c, c, iPlainInWord);
+            }
+        }
+
+        int iBody = lexer_add_rule_states(&pStates, pRule, 1000 - iRule);
+
+        int iState = iStart;
+        for (size_t i = 0; i < strlen(pRule->open); ++i) {
+            int iNext = (i+1 < strlen(pRule->open)) ? lexer_add_nfa_state(&pStates, -1, "default", 0) : iBody;
+            lexer_add_nfa_edge(pStates, iState, (unsigned char)pRule->open[i], (unsigned char)pRule->open[i], iNext);
+            iState = iNext;
+        }
+    }
+
+    return pStates;
+}
+
+int lexer_find_or_add_dfa_state(lexer_dfa_state** ppDFAStates, lexer_nfa_state* pNFAStates, int* pNFASet)
+{
+    for (int iState = 0; iState < stb_sb_count(*ppDFAStates); ++iState) {
+        int* pOtherSet = (*ppDFAStates)[iState].pNFASet;
+        if (stb_sb_count(pOtherSet) == stb_sb_count(pNFASet) && memcmp(pOtherSet, pNFASet, stb_sb_count(pNFASet) * sizeof(*pNFASet)) == 0) {
+            stb_sb_free(pNFASet);
+            return iState;
+        }
+    }
+
+    lexer_dfa_state state;
+    memset(&state, 0, sizeof(state));
+    state.pNFASet = pNFASet;
+    state.priority = -1;
+    state.category = "default";
+
+    // A state that is still inside something that continues onto the next line must be lexed as that, even if something else could end
+    // the token here. Otherwise the state with the highest priority decides how the token is highlighted.
+    dr_bool32 isContinuing = DR_FALSE;
+    for (int i = 0; i < stb_sb_count(pNFASet); ++i) {
+        lexer_nfa_state* pNFAState = &pNFAStates[pNFASet[i]];
+        if (pNFAState->priority < 0) {
+            continue;
+        }
+
+        dr_bool32 isNFAStateContinuing = (pNFAState->flags & LEXER_STATE_CONTINUES) != 0;
+        if ((isNFAStateContinuing && !isContinuing) || (isNFAStateContinuing == isContinuing && pNFAState->priority > state.priority)) {
+            state.priority = pNFAState->priority;
+            state.category = pNFAState->category;
+            state.flags = pNFAState->flags;
+            isContinuing = isNFAStateContinuing;
+        }
+    }
+
+    stb_sb_push(*ppDFAStates, state);
+    return stb_sb_count(*ppDFAStates) - 1;
+}
+
+int lexer_compare_ints(const void* a, const void* b)
+{
+    return *(const int*)a - *(const int*)b;
+}
+
+// Turns the NFA into a DFA with the subset construction. Each DFA state is the set of NFA states that could have been reached by the
+// characters of the token so far.
+lexer_dfa_state* lexer_build_dfa(lexer_nfa_state* pNFAStates)
+{
+    lexer_dfa_state* pDFAStates = NULL;
+
+    int* pStartSet = NULL;
+    stb_sb_push(pStartSet, 0);
+    lexer_find_or_add_dfa_state(&pDFAStates, pNFAStates, pStartSet);
+
+    for (int iState = 0; iState < stb_sb_count(pDFAStates); ++iState) {
+        for (unsigned int c = 0; c < 256; ++c) {
+            int* pNFASet = NULL;
+
+            int* pCurrentSet = pDFAStates[iState].pNFASet;
+            for (int i = 0; i < stb_sb_count(pCurrentSet); ++i) {
+                lexer_nfa_state* pNFAState = &pNFAStates[pCurrentSet[i]];
+                for (int iEdge = 0; iEdge < stb_sb_count(pNFAState->pEdges); ++iEdge) {
+                    lexer_nfa_edge* pEdge = &pNFAState->pEdges[iEdge];
+                    if (c < pEdge->lo || c > pEdge->hi) {
+                        continue;
+                    }
+
+                    dr_bool32 exists = DR_FALSE;
+                    for (int j = 0; j < stb_sb_count(pNFASet); ++j) {
+                        if (pNFASet[j] == pEdge->target) {
+                            exists = DR_TRUE;
+                        }
+                    }
+                    if (!exists) {
+                        stb_sb_push(pNFASet, pEdge->target);
+                    }
+                }
+            }
+
+            if (pNFASet == NULL) {
+                pDFAStates[iState].transitions[c] = -1;
+            } else {
+                // Adding the state can move the array, so the index needs to be retrieved before setting the transition.
+                qsort(pNFASet, stb_sb_count(pNFASet), sizeof(*pNFASet), lexer_compare_ints);
+                int iTarget = lexer_find_or_add_dfa_state(&pDFAStates, pNFAStates, pNFASet);
+                pDFAStates[iState].transitions[c] = iTarget;
+            }
+        }
+    }
+
+    return pDFAStates;
+}
+
+// Generates the lexer and keyword table of a language. The variables are named after the given suffix, such as g_LanguageCpp.
+void free_language(language* pLanguage)
+{
+    assert(pLanguage != NULL);
+
+    for (int iExtension = 0; iExtension < stb_sb_count(pLanguage->ppExtensions); ++iExtension) {
+        free(pLanguage->ppExtensions[iExtension]);
+    }
+    stb_sb_free(pLanguage->ppExtensions);
+    stb_sb_free(pLanguage->pRules);
+    stb_sb_free(pLanguage->pKeywords);
+}
+
+// Returns DR_FALSE if the language couldn't be generated correctly.
+dr_bool32 generate_language(FILE* pFileOut, const char* filename, const char* name, const char* suffix)
+{
+    assert(pFileOut != NULL);
+    assert(filename != NULL);
+    assert(name != NULL);
+    assert(suffix != NULL);
+
+    language lang;
+    memset(&lang, 0, sizeof(lang));
+    if (!parse_language(filename, &lang)) {
+        free_language(&lang);
+        return DR_FALSE;
+    }
+
+    char line[4096];
+    snprintf(line, sizeof(line), "g_KeywordTable%s", suffix);
+    generate_keyword_table(pFileOut, filename, lang.pKeywords, line);
+
+
+    lexer_nfa_state* pNFAStates = lexer_build_nfa(&lang);
+    lexer_dfa_state* pDFAStates = lexer_build_dfa(pNFAStates);
+    int stateCount = stb_sb_count(pDFAStates);
+    dr_bool32 result = DR_TRUE;
+    if (stateCount >= LEXER_ACCEPT_BIT) {
+        printf("%s: Too many lexer states: %d\n", filename, stateCount);
+        result = DR_FALSE;
+    }
+
+    // Characters that every state treats the same are put into the same class. This is what keeps the transition table small.
+    uint8_t charClasses[256];
+    unsigned int classChars[256];
+    unsigned int classCount = 0;
+    for (unsigned int c = 0; c < 256; ++c) {
+        unsigned int iClass;
+        for (iClass = 0; iClass < classCount; ++iClass) {
+            int iState;
+            for (iState = 0; iState < stateCount; ++iState) {
+                if (pDFAStates[iState].transitions[c] != pDFAStates[iState].transitions[classChars[iClass]]) {
+                    break;
+                }
+            }
+
+            if (iState == stateCount) {
+                break;
+            }
+        }
+
+        if (iClass == classCount) {
+            classChars[classCount++] = c;
+        }
+
+        charClasses[c] = (uint8_t)iClass;
+    }
+
+
+    char* lexerOutput = gb_make_string("");
+    snprintf(line, sizeof(line), "uint8_t g_Lexer%s_CharClasses[256] = {", suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+    for (unsigned int c = 0; c < 256; ++c) {
+        snprintf(line, sizeof(line), "%s%d,", (c % 32 == 0) ? "\n    " : " ", charClasses[c]);
+        lexerOutput = gb_append_cstring(lexerOutput, line);
+    }
+    lexerOutput = gb_append_cstring(lexerOutput, "\n};\n\n");
+
+    snprintf(line, sizeof(line), "uint16_t g_Lexer%s_Transitions[] = {\n", suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+    for (int iState = 0; iState < stateCount; ++iState) {
+        for (unsigned int iClass = 0; iClass < classCount; ++iClass) {
+            int iTarget = pDFAStates[iState].transitions[classChars[iClass]];
+            unsigned int transition = LEXER_DEAD_STATE;
+            if (iTarget != -1) {
+                transition = (unsigned int)iTarget | ((pDFAStates[iTarget].priority >= 0) ? LEXER_ACCEPT_BIT : 0);
+            }
+
+            snprintf(line, sizeof(line), "%s0x%04X,", (iClass % 16 == 0) ? (iClass == 0 ? "    " : "\n    ") : " ", transition);
+            lexerOutput = gb_append_cstring(lexerOutput, line);
+        }
+        lexerOutput = gb_append_cstring(lexerOutput, "\n");
+    }
+    lexerOutput = gb_append_cstring(lexerOutput, "};\n\n");
+
+    snprintf(line, sizeof(line), "uint8_t g_Lexer%s_StateCategories[] = {", suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+    for (int iState = 0; iState < stateCount; ++iState) {
+        snprintf(line, sizeof(line), "%sdred_highlight_category_%s,", (iState % 4 == 0) ? "\n    " : " ", pDFAStates[iState].category);
+        lexerOutput = gb_append_cstring(lexerOutput, line);
+    }
+    lexerOutput = gb_append_cstring(lexerOutput, "\n};\n\n");
+
+    snprintf(line, sizeof(line), "uint8_t g_Lexer%s_StateFlags[] = {", suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+    for (int iState = 0; iState < stateCount; ++iState) {
+        snprintf(line, sizeof(line), "%s%d,", (iState % 32 == 0) ? "\n    " : " ", pDFAStates[iState].flags);
+        lexerOutput = gb_append_cstring(lexerOutput, line);
+    }
+    lexerOutput = gb_append_cstring(lexerOutput, "\n};\n\n");
+
+    snprintf(line, sizeof(line), "const char* g_Language%s_Extensions[] = {", suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+    for (int iExtension = 0; iExtension < stb_sb_count(lang.ppExtensions); ++iExtension) {
+        snprintf(line, sizeof(line), "\"%s\", ", lang.ppExtensions[iExtension]);
+        lexerOutput = gb_append_cstring(lexerOutput, line);
+    }
+    lexerOutput = gb_append_cstring(lexerOutput, "NULL};\n\n");
+
+    snprintf(line, sizeof(line), "dred_highlight_language g_Language%s = {\"%s\", g_Language%s_Extensions, %d, %d, g_Lexer%s_CharClasses, g_Lexer%s_Transitions, g_Lexer%s_StateCategories, g_Lexer%s_StateFlags, &g_KeywordTable%s};\n\n",
+        suffix, name, suffix, stateCount, classCount, suffix, suffix, suffix, suffix, suffix);
+    lexerOutput = gb_append_cstring(lexerOutput, line);
+
+    fwrite_string(pFileOut, lexerOutput);
+    gb_free_string(lexerOutput);
+
+
+    for (int iState = 0; iState < stateCount; ++iState) {
+        stb_sb_free(pDFAStates[iState].pNFASet);
+    }
+    stb_sb_free(pDFAStates);
+
+    for (int iState = 0; iState < stb_sb_count(pNFAStates); ++iState) {
+        stb_sb_free(pNFAStates[iState].pEdges);
+    }
+    stb_sb_free(pNFAStates);
+
+    free_language(&lang);
+    return result;
+}
+
+// Returns DR_FALSE if any of the languages couldn't be generated.
+dr_bool32 generate_languages(FILE* pFileOut)
+{
+    assert(pFileOut != NULL);
+
+    size_t sourceFileDataSize;
+    char* sourceFileData = dr_open_and_read_text_file("../../../source/dred/dred_highlighters.h", &sourceFileDataSize);
+    if (sourceFileData == NULL) {
+        return DR_FALSE;
+    }
+
+    // Look for the line beginning with "// BEGIN LANGUAGE LIST"
+    char line[1024];
+    const char* nextLine = sourceFileData;
+    while (nextLine != NULL) {
+        if (dr_copy_line(nextLine, line, sizeof(line)) == (size_t)-1) {
+            dr_free_file_data(sourceFileData);
+            return DR_FALSE;
+        }
+        if (strstr(line, "// BEGIN LANGUAGE LIST") != NULL) {
+            nextLine = dr_next_line(nextLine);
+            break;
+        }
+        nextLine = dr_next_line(nextLine);
+    }
+
+    fwrite_string(pFileOut, "\n\n// Languages\n");
+
+    char* languagesOutput = gb_make_string("");
+    int languageCount = 0;
+    dr_bool32 result = DR_TRUE;
+
+    while (nextLine != NULL) {
+        // The next line should be in the format of <filename> <language name>
+        size_t lineLength = dr_copy_line(nextLine, line, sizeof(line));
+        if (lineLength <= 2) {
+            nextLine = dr_next_line(nextLine);
+            continue;
+        }
+
+        if (strstr(line, "// END LANGUAGE LIST") != NULL) {
+            break;
+        }
+
+        char filename[256];
+        const char* next = dr_next_token(line + 2, filename, sizeof(filename));     // Skip past "//"
+        if (next == NULL) {
+            nextLine = dr_next_line(nextLine);
+            continue;
+        }
+
+        char name[256];
+        next = dr_next_token(next, name, sizeof(name));
+        if (next == NULL) {
+            nextLine = dr_next_line(nextLine);
+            continue;
+        }
+
+        // The generated variables are named after the language with the first letter capitalized.
+        char suffix[256];
+        strcpy_s(suffix, sizeof(suffix), name);
+        if (suffix[0] >= 'a' && suffix[0] <= 'z') {
+            suffix[0] = suffix[0] - 'a' + 'A';
+        }
+
+        if (!generate_language(pFileOut, filename, name, suffix)) {
+            result = DR_FALSE;
+        }
+
+        snprintf(line, sizeof(line), "    &g_Language%s,\n", suffix);
+        languagesOutput = gb_append_cstring(languagesOutput, line);
+        languageCount += 1;
+
+        nextLine = dr_next_line(nextLine + lineLength);
+    }
+
+    snprintf(line, sizeof(line), "#define DRED_LANGUAGE_COUNT %d\n\n", languageCount);
+    fwrite_string(pFileOut, line);
+    fwrite_string(pFileOut, "dred_highlight_language* g_Languages[DRED_LANGUAGE_COUNT] = {\n");
+    fwrite_string(pFileOut, languagesOutput);
+    fwrite_string(pFileOut, "};\n");
+
+    gb_free_string(languagesOutput);
+    dr_free_file_data(sourceFileData);
+    return result;
+}
+
 int main(int argc, char** argv)
 {
     (void)argc;
@@ -880,10 +1781,18 @@ int main(int argc, char** argv)
     // Config vars.
     generate_config_vars(pFileOut, pFileOutH);
 
+    // Languages for highlighters.
+    dr_bool32 languagesGenerated = generate_languages(pFileOut);
+
 
     fclose(pFileOut);
     fclose(pFileOutH);
 
+    if (!languagesGenerated) {
+        printf("Failed to generate languages.");
+        return -1;
+    }
+
 
     // Website.
     dred_build__generate_website(g_CommandVars, g_ConfigVars);
@@ -33,6 +33,11 @@
 // #define DR2D_NO_CAIRO
 //   Excludes the Cairo back-end.
 //
+// #define DR2D_CAIRO_GLYPH_ATLAS
+//   Makes the Cairo back-end keep the glyphs of each font in an atlas after Cairo has rasterized them once. Text drawn onto surfaces
+//   created with dr2d_create_surface() is then blitted from the atlas on the CPU. Text is still drawn by Cairo whenever the atlas
+//   can't reproduce Cairo's output exactly, such as for translucent colors or glyphs that don't sit on pixel boundaries.
+//
 //
 //
 // TODO
@@ -101,6 +106,10 @@ struct dr2d_font_metrics
     int descent;
     int lineHeight;
     int spaceWidth;
+
+    // Whether or not every printable ASCII character advances by exactly spaceWidth. When this is set the width of ASCII text can
+    // be calculated from the number of characters without measuring it.
+    dr_bool32 isMonospace;
 };
 
 struct dr2d_glyph_metrics
@@ -1723,6 +1732,9 @@ dr_bool32 dr2d_on_create_font_gdi(dr2d_font* pFont)
         } else {
             pGDIData->metrics.spaceWidth = spaceMetrics.gmCellIncX;
         }
+
+        // Note that TMPF_FIXED_PITCH is set when the font is _not_ fixed pitch.
+        pGDIData->metrics.isMonospace = (metrics.tmPitchAndFamily & TMPF_FIXED_PITCH) == 0 && metrics.tmOverhang == 0 && metrics.tmAveCharWidth == pGDIData->metrics.spaceWidth;
     }
     SelectObject(pGDIContextData->hDC, hPrevFont);
 
@@ -2613,11 +2625,34 @@ fallback:;
 /////////////////////////////////////////////////////////////////
 #ifndef DR2D_NO_CAIRO
 
+// The maximum number of glyphs passed to a single call to cairo_show_glyphs(). Longer strings are drawn in multiple calls.
+#ifndef DR2D_CAIRO_GLYPH_BATCH_SIZE
+#define DR2D_CAIRO_GLYPH_BATCH_SIZE   256
+#endif
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+// The width of each font's glyph atlas and the height it's allowed to grow to before it's cleared.
+#ifndef DR2D_CAIRO_GLYPH_ATLAS_WIDTH
+#define DR2D_CAIRO_GLYPH_ATLAS_WIDTH        512
+#endif
+#ifndef DR2D_CAIRO_GLYPH_ATLAS_MAX_HEIGHT
+#define DR2D_CAIRO_GLYPH_ATLAS_MAX_HEIGHT   2048
+#endif
+
+// The number of pixels left around the ink of each glyph in the atlas. Antialiasing and subpixel filtering can spread a glyph a little
+// past it's ink extents.
+#define DR2D_CAIRO_GLYPH_ATLAS_PADDING      3
+#endif
+
 typedef struct
 {
     cairo_surface_t* pCairoSurface;
     cairo_t* pCairoContext;
 
+    // Whether or not the surface is an image surface created by dr_2d, as opposed to one wrapping a cairo_t from somewhere else. Only
+    // these can be drawn to directly since their clip is known to be a rectangle.
+    dr_bool32 ownsCairoSurface;
+
     float clipRectLeft;
     float clipRectTop;
     float clipRectRight;
@@ -2625,6 +2660,35 @@ typedef struct
 
 } cairo_surface_data;
 
+typedef struct
+{
+    unsigned int utf32;         // 0 if the slot is empty. Code point 0 is ASCII so it never needs a slot.
+    dr_bool32 hasGlyph;         // False if Cairo couldn't map the code point to a glyph, in which case nothing is drawn for it.
+    unsigned long glyphIndex;
+    float advanceX;
+} cairo_glyph_data;
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+typedef struct
+{
+    unsigned long key;          // The glyph index plus one, or 0 if the slot is empty.
+    dr_bool32 isMask;           // False for glyphs with colors of their own, such as emoji. These can't be drawn from the atlas.
+    int cellX;
+    int cellY;
+    int cellWidth;
+    int cellHeight;
+    int originX;                // The position of the glyph's origin relative to the top left corner of it's cell.
+    int originY;
+
+    // The ink box of the glyph relative to it's origin in Cairo's 24.8 fixed point format. Cairo uses these to decide whether or not
+    // glyphs overlap, which changes how they are composited.
+    dr_int32 bboxLeft;
+    dr_int32 bboxTop;
+    dr_int32 bboxRight;
+    dr_int32 bboxBottom;
+} cairo_atlas_glyph;
+#endif
+
 typedef struct
 {
     cairo_font_face_t* pFace;
@@ -2633,6 +2697,37 @@ typedef struct
     // The font metrics. This is initialized when the font is created.
     dr2d_font_metrics metrics;
 
+    // The glyph index and advance of each code point, retrieved from Cairo the first time it's needed. ASCII is looked up directly
+    // and everything else goes through an open addressed hash table, the capacity of which is always a power of two.
+    cairo_glyph_data asciiGlyphs[128];
+    dr_bool8 hasAsciiGlyph[128];
+    cairo_glyph_data* pGlyphs;
+    size_t glyphCount;
+    size_t glyphCapacity;
+
+    // Where a glyph is stored when it can't be added to the hash table.
+    cairo_glyph_data uncachedGlyph;
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+    // The glyph atlas. Each glyph is rasterized by Cairo into it's own cell the first time it's drawn. Cells are packed into rows, and
+    // the surface grows downwards until it reaches it's maximum height at which point it's cleared. The cells are looked up by glyph
+    // index through an open addressed hash table.
+    cairo_surface_t* pAtlasSurface;
+    cairo_t* pAtlasContext;
+    int atlasHeight;
+    int atlasRowX;
+    int atlasRowY;
+    int atlasRowHeight;
+    unsigned int atlasClearCount;
+    cairo_atlas_glyph* pAtlasGlyphs;
+    size_t atlasGlyphCount;
+    size_t atlasGlyphCapacity;
+
+    // Scratch space for combining the masks of overlapping glyphs.
+    dr_uint32* pAtlasMask;
+    size_t atlasMaskCapacity;
+#endif
+
 } cairo_font_data;
 
 typedef struct
@@ -2678,6 +2773,10 @@ dr_bool32 dr2d_measure_string_cairo(dr2d_font* pFont, const char* text, size_t t
 dr_bool32 dr2d_get_text_cursor_position_from_point_cairo(dr2d_font* pFont, const char* text, size_t textSizeInBytes, float maxWidth, float inputPosX, float* pTextCursorPosXOut, size_t* pCharacterIndexOut);
 dr_bool32 dr2d_get_text_cursor_position_from_char_cairo(dr2d_font* pFont, const char* text, size_t characterIndex, float* pTextCursorPosXOut);
 
+static unsigned int dr2d__utf8_decode(const char* text, size_t textSizeInBytes, size_t* pByteCountOut);
+static const cairo_glyph_data* dr2d__get_glyph_cairo(cairo_font_data* pCairoFont, unsigned int utf32);
+static void dr2d__show_glyphs_cairo(cairo_surface_data* pCairoSurface, dr2d_font* pFont, const cairo_glyph_t* pGlyphs, int glyphCount, dr2d_color color);
+
 
 dr2d_context* dr2d_create_context_cairo()
 {
@@ -2792,9 +2891,12 @@ dr_bool32 dr2d_on_create_surface_cairo(dr2d_surface* pSurface, float width, floa
             cairo_surface_destroy(pCairoData->pCairoSurface);
             return DR_FALSE;
         }
+
+        pCairoData->ownsCairoSurface = DR_TRUE;
     } else {
         pCairoData->pCairoSurface = NULL;
         pCairoData->pCairoContext = NULL;
+        pCairoData->ownsCairoSurface = DR_FALSE;
     }
 
 
@@ -2869,6 +2971,39 @@ dr_bool32 dr2d_on_create_font_cairo(dr2d_font* pFont)
     cairo_scaled_font_text_extents(pCairoFont->pFont, space, &spaceMetrics);
     pCairoFont->metrics.spaceWidth = spaceMetrics.x_advance;
 
+    // Glyphs are retrieved lazily.
+    memset(pCairoFont->hasAsciiGlyph, 0, sizeof(pCairoFont->hasAsciiGlyph));
+    pCairoFont->pGlyphs = NULL;
+    pCairoFont->glyphCount = 0;
+    pCairoFont->glyphCapacity = 0;
+
+    // The font is only treated as monospaced if every printable ASCII character advances by the same whole number of pixels as a
+    // space, since that's the width text will be measured as.
+    pCairoFont->metrics.isMonospace = DR_TRUE;
+    for (unsigned int utf32 = ' '; utf32 <= '~'; ++utf32) {
+        const cairo_glyph_data* pGlyph = dr2d__get_glyph_cairo(pCairoFont, utf32);
+        if (!pGlyph->hasGlyph || pGlyph->advanceX != (float)pCairoFont->metrics.spaceWidth) {
+            pCairoFont->metrics.isMonospace = DR_FALSE;
+            break;
+        }
+    }
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+    // The atlas is created when the first glyph is drawn.
+    pCairoFont->pAtlasSurface = NULL;
+    pCairoFont->pAtlasContext = NULL;
+    pCairoFont->atlasHeight = 0;
+    pCairoFont->atlasRowX = 0;
+    pCairoFont->atlasRowY = 0;
+    pCairoFont->atlasRowHeight = 0;
+    pCairoFont->atlasClearCount = 0;
+    pCairoFont->pAtlasGlyphs = NULL;
+    pCairoFont->atlasGlyphCount = 0;
+    pCairoFont->atlasGlyphCapacity = 0;
+    pCairoFont->pAtlasMask = NULL;
+    pCairoFont->atlasMaskCapacity = 0;
+#endif
+
     return DR_TRUE;
 }
 
@@ -2879,6 +3014,19 @@ void dr2d_on_delete_font_cairo(dr2d_font* pFont)
         return;
     }
 
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+    if (pCairoFont->pAtlasContext != NULL) {
+        cairo_destroy(pCairoFont->pAtlasContext);
+    }
+    if (pCairoFont->pAtlasSurface != NULL) {
+        cairo_surface_destroy(pCairoFont->pAtlasSurface);
+    }
+
+    free(pCairoFont->pAtlasGlyphs);
+    free(pCairoFont->pAtlasMask);
+#endif
+
+    free(pCairoFont->pGlyphs);
     cairo_scaled_font_destroy(pCairoFont->pFont);
     cairo_font_face_destroy(pCairoFont->pFace);
 }
@@ -3054,14 +3202,8 @@ void dr2d_draw_text_cairo(dr2d_surface* pSurface, dr2d_font* pFont, const char*
         return;
     }
 
-    // Cairo expends null terminated strings, however the input string is not guaranteed to be null terminated.
-    char* textNT;
-    if (textSizeInBytes != (size_t)-1) {
-        textNT = malloc(textSizeInBytes + 1);
-        memcpy(textNT, text, textSizeInBytes);
-        textNT[textSizeInBytes] = '\0';
-    } else {
-        textNT = (char*)text;
+    if (textSizeInBytes == (size_t)-1) {
+        textSizeInBytes = strlen(text);
     }
 
 
@@ -3070,21 +3212,45 @@ void dr2d_draw_text_cairo(dr2d_surface* pSurface, dr2d_font* pFont, const char*
 
 
     // Background.
-    cairo_text_extents_t textMetrics;
-    cairo_text_extents(cr, textNT, &textMetrics);
+    float textWidth;
+    dr2d_measure_string_cairo(pFont, text, textSizeInBytes, &textWidth, NULL);
     cairo_set_source_rgba(cr, backgroundColor.r / 255.0, backgroundColor.g / 255.0, backgroundColor.b / 255.0, backgroundColor.a / 255.0);
-    cairo_rectangle(cr, posX, posY, textMetrics.x_advance, pCairoFont->metrics.lineHeight);
+    cairo_rectangle(cr, posX, posY, textWidth, pCairoFont->metrics.lineHeight);
     cairo_fill(cr);
 
 
-    // Text.
-    cairo_move_to(cr, posX, posY + pCairoFont->metrics.ascent);
+    // Text. The glyphs are positioned the same way cairo_show_text() would position them, but using the font's cached glyphs rather
+    // than converting the text again. They're drawn in batches so that the glyph buffer can live on the stack.
     cairo_set_source_rgba(cr, color.r / 255.0, color.g / 255.0, color.b / 255.0, color.a / 255.0);
-    cairo_show_text(cr, textNT);
 
+    cairo_glyph_t glyphs[DR2D_CAIRO_GLYPH_BATCH_SIZE];
+    int glyphCount = 0;
+
+    double glyphPosX = posX;
+    double glyphPosY = posY + pCairoFont->metrics.ascent;
+    for (size_t iByte = 0; iByte < textSizeInBytes; /* Do Nothing */) {
+        size_t byteCount;
+        unsigned int utf32 = dr2d__utf8_decode(text + iByte, textSizeInBytes - iByte, &byteCount);
+        iByte += byteCount;
+
+        const cairo_glyph_data* pGlyph = dr2d__get_glyph_cairo(pCairoFont, utf32);
+        if (pGlyph->hasGlyph) {
+            glyphs[glyphCount].index = pGlyph->glyphIndex;
+            glyphs[glyphCount].x     = glyphPosX;
+            glyphs[glyphCount].y     = glyphPosY;
+            glyphCount += 1;
+
+            if (glyphCount == DR2D_CAIRO_GLYPH_BATCH_SIZE) {
+                dr2d__show_glyphs_cairo(pCairoSurface, pFont, glyphs, glyphCount, color);
+                glyphCount = 0;
+            }
+        }
+
+        glyphPosX += pGlyph->advanceX;
+    }
 
-    if (textNT != text) {
-        free(textNT);
+    if (glyphCount > 0) {
+        dr2d__show_glyphs_cairo(pCairoSurface, pFont, glyphs, glyphCount, color);
     }
 }
 
@@ -3267,6 +3433,671 @@ static size_t dr2d__utf32_to_utf8(unsigned int utf32, char* utf8, size_t utf8Siz
     return utf8ByteCount;
 }
 
+// Decodes the UTF-8 character at the start of the given string. A malformed sequence is decoded as U+FFFD one byte at a time.
+static unsigned int dr2d__utf8_decode(const char* text, size_t textSizeInBytes, size_t* pByteCountOut)
+{
+    assert(text != NULL);
+    assert(textSizeInBytes > 0);
+    assert(pByteCountOut != NULL);
+
+    const unsigned char* utf8 = (const unsigned char*)text;
+
+    *pByteCountOut = 1;
+    if (utf8[0] < 0x80) {
+        return utf8[0];
+    }
+
+    size_t byteCount;
+    unsigned int utf32;
+    if ((utf8[0] & 0xE0) == 0xC0) {
+        byteCount = 2;
+        utf32 = utf8[0] & 0x1F;
+    } else if ((utf8[0] & 0xF0) == 0xE0) {
+        byteCount = 3;
+        utf32 = utf8[0] & 0x0F;
+    } else if ((utf8[0] & 0xF8) == 0xF0) {
+        byteCount = 4;
+        utf32 = utf8[0] & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+
+    if (byteCount > textSizeInBytes) {
+        return 0xFFFD;
+    }
+
+    for (size_t i = 1; i < byteCount; ++i) {
+        if ((utf8[i] & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+
+        utf32 = (utf32 << 6) | (utf8[i] & 0x3F);
+    }
+
+    *pByteCountOut = byteCount;
+    return utf32;
+}
+
+static void dr2d__retrieve_glyph_cairo(cairo_font_data* pCairoFont, unsigned int utf32, cairo_glyph_data* pGlyphOut)
+{
+    assert(pCairoFont != NULL);
+    assert(pGlyphOut != NULL);
+
+    pGlyphOut->utf32      = utf32;
+    pGlyphOut->hasGlyph   = DR_FALSE;
+    pGlyphOut->glyphIndex = 0;
+    pGlyphOut->advanceX   = 0;
+
+    char utf8[16];
+    size_t utf8len = dr2d__utf32_to_utf8(utf32, utf8, sizeof(utf8));
+    if (utf8len == 0 || utf32 == 0) {
+        return;
+    }
+
+    // Cairo only allocates the glyph buffer itself if the one we give it is too small.
+    cairo_glyph_t glyphs[4];
+    cairo_glyph_t* pGlyphs = glyphs;
+    int glyphCount = (int)(sizeof(glyphs) / sizeof(glyphs[0]));
+    cairo_status_t result = cairo_scaled_font_text_to_glyphs(pCairoFont->pFont, 0, 0, utf8, (int)utf8len, &pGlyphs, &glyphCount, NULL, NULL, NULL);
+    if (result != CAIRO_STATUS_SUCCESS) {
+        return;
+    }
+
+    if (glyphCount > 0) {
+        cairo_text_extents_t glyphExtents;
+        cairo_scaled_font_glyph_extents(pCairoFont->pFont, pGlyphs, glyphCount, &glyphExtents);
+
+        pGlyphOut->hasGlyph   = DR_TRUE;
+        pGlyphOut->glyphIndex = pGlyphs[0].index;
+        pGlyphOut->advanceX   = (float)glyphExtents.x_advance;
+    }
+
+    if (pGlyphs != glyphs) {
+        cairo_glyph_free(pGlyphs);
+    }
+}
+
+static cairo_glyph_data* dr2d__find_glyph_slot_cairo(cairo_glyph_data* pGlyphs, size_t capacity, unsigned int utf32)
+{
+    assert(pGlyphs != NULL);
+    assert(capacity > 0);
+
+    size_t iSlot = (size_t)(utf32 * 2654435761U) & (capacity - 1);
+    while (pGlyphs[iSlot].utf32 != 0 && pGlyphs[iSlot].utf32 != utf32) {
+        iSlot = (iSlot + 1) & (capacity - 1);
+    }
+
+    return &pGlyphs[iSlot];
+}
+
+// Retrieves the glyph index and advance of the given code point. Only the first call for each code point goes to Cairo.
+static const cairo_glyph_data* dr2d__get_glyph_cairo(cairo_font_data* pCairoFont, unsigned int utf32)
+{
+    assert(pCairoFont != NULL);
+
+    if (utf32 < 128) {
+        if (!pCairoFont->hasAsciiGlyph[utf32]) {
+            dr2d__retrieve_glyph_cairo(pCairoFont, utf32, &pCairoFont->asciiGlyphs[utf32]);
+            pCairoFont->hasAsciiGlyph[utf32] = DR_TRUE;
+        }
+
+        return &pCairoFont->asciiGlyphs[utf32];
+    }
+
+    if (pCairoFont->glyphCapacity > 0) {
+        cairo_glyph_data* pSlot = dr2d__find_glyph_slot_cairo(pCairoFont->pGlyphs, pCairoFont->glyphCapacity, utf32);
+        if (pSlot->utf32 == utf32) {
+            return pSlot;
+        }
+    }
+
+    // Keep the table at most three quarters full. If it can't be grown the glyph is simply not cached.
+    if ((pCairoFont->glyphCount + 1) * 4 > pCairoFont->glyphCapacity * 3) {
+        size_t newCapacity = (pCairoFont->glyphCapacity == 0) ? 64 : pCairoFont->glyphCapacity*2;
+        cairo_glyph_data* pNewGlyphs = (cairo_glyph_data*)calloc(newCapacity, sizeof(*pNewGlyphs));
+        if (pNewGlyphs == NULL) {
+            dr2d__retrieve_glyph_cairo(pCairoFont, utf32, &pCairoFont->uncachedGlyph);
+            return &pCairoFont->uncachedGlyph;
+        }
+
+        for (size_t iSlot = 0; iSlot < pCairoFont->glyphCapacity; ++iSlot) {
+            if (pCairoFont->pGlyphs[iSlot].utf32 != 0) {
+                *dr2d__find_glyph_slot_cairo(pNewGlyphs, newCapacity, pCairoFont->pGlyphs[iSlot].utf32) = pCairoFont->pGlyphs[iSlot];
+            }
+        }
+
+        free(pCairoFont->pGlyphs);
+        pCairoFont->pGlyphs = pNewGlyphs;
+        pCairoFont->glyphCapacity = newCapacity;
+    }
+
+    cairo_glyph_data* pSlot = dr2d__find_glyph_slot_cairo(pCairoFont->pGlyphs, pCairoFont->glyphCapacity, utf32);
+    dr2d__retrieve_glyph_cairo(pCairoFont, utf32, pSlot);
+    pCairoFont->glyphCount += 1;
+
+    return pSlot;
+}
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+static cairo_atlas_glyph* dr2d__find_atlas_glyph_slot_cairo(cairo_atlas_glyph* pAtlasGlyphs, size_t capacity, unsigned long glyphIndex)
+{
+    assert(pAtlasGlyphs != NULL);
+    assert(capacity > 0);
+
+    size_t iSlot = (size_t)(glyphIndex * 2654435761U) & (capacity - 1);
+    while (pAtlasGlyphs[iSlot].key != 0 && pAtlasGlyphs[iSlot].key != glyphIndex + 1) {
+        iSlot = (iSlot + 1) & (capacity - 1);
+    }
+
+    return &pAtlasGlyphs[iSlot];
+}
+
+static cairo_atlas_glyph* dr2d__find_atlas_glyph_cairo(cairo_font_data* pCairoFont, unsigned long glyphIndex)
+{
+    assert(pCairoFont != NULL);
+
+    if (pCairoFont->atlasGlyphCapacity == 0) {
+        return NULL;
+    }
+
+    cairo_atlas_glyph* pSlot = dr2d__find_atlas_glyph_slot_cairo(pCairoFont->pAtlasGlyphs, pCairoFont->atlasGlyphCapacity, glyphIndex);
+    if (pSlot->key == 0) {
+        return NULL;
+    }
+
+    return pSlot;
+}
+
+// Throws away every glyph in the atlas. They'll be rasterized again the next time they're drawn.
+static void dr2d__clear_glyph_atlas_cairo(cairo_font_data* pCairoFont)
+{
+    assert(pCairoFont != NULL);
+
+    if (pCairoFont->pAtlasSurface != NULL) {
+        cairo_surface_flush(pCairoFont->pAtlasSurface);
+        memset(cairo_image_surface_get_data(pCairoFont->pAtlasSurface), 0, (size_t)cairo_image_surface_get_stride(pCairoFont->pAtlasSurface) * pCairoFont->atlasHeight);
+        cairo_surface_mark_dirty(pCairoFont->pAtlasSurface);
+    }
+
+    if (pCairoFont->pAtlasGlyphs != NULL) {
+        memset(pCairoFont->pAtlasGlyphs, 0, sizeof(*pCairoFont->pAtlasGlyphs) * pCairoFont->atlasGlyphCapacity);
+    }
+
+    pCairoFont->atlasGlyphCount = 0;
+    pCairoFont->atlasRowX = 0;
+    pCairoFont->atlasRowY = 0;
+    pCairoFont->atlasRowHeight = 0;
+    pCairoFont->atlasClearCount += 1;
+}
+
+static dr_bool32 dr2d__resize_glyph_atlas_cairo(cairo_font_data* pCairoFont, int newHeight)
+{
+    assert(pCairoFont != NULL);
+    assert(newHeight > pCairoFont->atlasHeight);
+
+    cairo_surface_t* pNewSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, DR2D_CAIRO_GLYPH_ATLAS_WIDTH, newHeight);
+    if (cairo_surface_status(pNewSurface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(pNewSurface);
+        return DR_FALSE;
+    }
+
+    cairo_t* pNewContext = cairo_create(pNewSurface);
+    if (cairo_status(pNewContext) != CAIRO_STATUS_SUCCESS) {
+        cairo_destroy(pNewContext);
+        cairo_surface_destroy(pNewSurface);
+        return DR_FALSE;
+    }
+
+    // The old glyphs are kept in the same place.
+    if (pCairoFont->pAtlasSurface != NULL) {
+        cairo_surface_flush(pCairoFont->pAtlasSurface);
+        cairo_surface_flush(pNewSurface);
+
+        const unsigned char* pOldData = cairo_image_surface_get_data(pCairoFont->pAtlasSurface);
+        int oldStride = cairo_image_surface_get_stride(pCairoFont->pAtlasSurface);
+        unsigned char* pNewData = cairo_image_surface_get_data(pNewSurface);
+        int newStride = cairo_image_surface_get_stride(pNewSurface);
+        for (int y = 0; y < pCairoFont->atlasHeight; ++y) {
+            memcpy(pNewData + y*newStride, pOldData + y*oldStride, DR2D_CAIRO_GLYPH_ATLAS_WIDTH*4);
+        }
+
+        cairo_surface_mark_dirty(pNewSurface);
+
+        cairo_destroy(pCairoFont->pAtlasContext);
+        cairo_surface_destroy(pCairoFont->pAtlasSurface);
+    }
+
+    pCairoFont->pAtlasSurface = pNewSurface;
+    pCairoFont->pAtlasContext = pNewContext;
+    pCairoFont->atlasHeight = newHeight;
+
+    return DR_TRUE;
+}
+
+// Finds room in the atlas for a cell of the given size. This will clear the atlas if it's full.
+static dr_bool32 dr2d__allocate_atlas_cell_cairo(cairo_font_data* pCairoFont, int width, int height, int* pXOut, int* pYOut)
+{
+    assert(pCairoFont != NULL);
+    assert(pXOut != NULL);
+    assert(pYOut != NULL);
+
+    if (width > DR2D_CAIRO_GLYPH_ATLAS_WIDTH || height > DR2D_CAIRO_GLYPH_ATLAS_MAX_HEIGHT) {
+        return DR_FALSE;
+    }
+
+    if (pCairoFont->atlasRowX + width > DR2D_CAIRO_GLYPH_ATLAS_WIDTH) {
+        pCairoFont->atlasRowX = 0;
+        pCairoFont->atlasRowY += pCairoFont->atlasRowHeight;
+        pCairoFont->atlasRowHeight = 0;
+    }
+
+    if (pCairoFont->atlasRowY + height > pCairoFont->atlasHeight) {
+        int newHeight = (pCairoFont->atlasHeight == 0) ? 64 : pCairoFont->atlasHeight;
+        while (newHeight < pCairoFont->atlasRowY + height) {
+            newHeight *= 2;
+        }
+
+        if (newHeight > DR2D_CAIRO_GLYPH_ATLAS_MAX_HEIGHT) {
+            dr2d__clear_glyph_atlas_cairo(pCairoFont);
+        } else {
+            if (!dr2d__resize_glyph_atlas_cairo(pCairoFont, newHeight)) {
+                return DR_FALSE;
+            }
+        }
+    }
+
+    *pXOut = pCairoFont->atlasRowX;
+    *pYOut = pCairoFont->atlasRowY;
+
+    pCairoFont->atlasRowX += width;
+    if (pCairoFont->atlasRowHeight < height) {
+        pCairoFont->atlasRowHeight = height;
+    }
+
+    return DR_TRUE;
+}
+
+// Has Cairo rasterize the given glyph into a new cell in the atlas.
+static dr_bool32 dr2d__rasterize_atlas_glyph_cairo(cairo_font_data* pCairoFont, unsigned long glyphIndex, cairo_atlas_glyph* pAtlasGlyphOut)
+{
+    assert(pCairoFont != NULL);
+    assert(pAtlasGlyphOut != NULL);
+
+    cairo_glyph_t glyph;
+    glyph.index = glyphIndex;
+    glyph.x = 0;
+    glyph.y = 0;
+
+    cairo_text_extents_t glyphExtents;
+    cairo_scaled_font_glyph_extents(pCairoFont->pFont, &glyph, 1, &glyphExtents);
+
+    int inkLeft   = (int)floor(glyphExtents.x_bearing) - DR2D_CAIRO_GLYPH_ATLAS_PADDING;
+    int inkTop    = (int)floor(glyphExtents.y_bearing) - DR2D_CAIRO_GLYPH_ATLAS_PADDING;
+    int inkRight  = (int)ceil(glyphExtents.x_bearing + glyphExtents.width)  + DR2D_CAIRO_GLYPH_ATLAS_PADDING;
+    int inkBottom = (int)ceil(glyphExtents.y_bearing + glyphExtents.height) + DR2D_CAIRO_GLYPH_ATLAS_PADDING;
+
+    int cellX;
+    int cellY;
+    if (!dr2d__allocate_atlas_cell_cairo(pCairoFont, inkRight - inkLeft, inkBottom - inkTop, &cellX, &cellY)) {
+        return DR_FALSE;
+    }
+
+    pAtlasGlyphOut->key        = glyphIndex + 1;
+    pAtlasGlyphOut->cellX      = cellX;
+    pAtlasGlyphOut->cellY      = cellY;
+    pAtlasGlyphOut->cellWidth  = inkRight - inkLeft;
+    pAtlasGlyphOut->cellHeight = inkBottom - inkTop;
+    pAtlasGlyphOut->originX    = -inkLeft;
+    pAtlasGlyphOut->originY    = -inkTop;
+    pAtlasGlyphOut->bboxLeft   = (dr_int32)lrint(glyphExtents.x_bearing * 256);
+    pAtlasGlyphOut->bboxTop    = (dr_int32)lrint(glyphExtents.y_bearing * 256);
+    pAtlasGlyphOut->bboxRight  = (dr_int32)lrint((glyphExtents.x_bearing + glyphExtents.width)  * 256);
+    pAtlasGlyphOut->bboxBottom = (dr_int32)lrint((glyphExtents.y_bearing + glyphExtents.height) * 256);
+
+    glyph.x = cellX - inkLeft;
+    glyph.y = cellY - inkTop;
+
+    cairo_t* cr = pCairoFont->pAtlasContext;
+    cairo_save(cr);
+    cairo_rectangle(cr, cellX, cellY, pAtlasGlyphOut->cellWidth, pAtlasGlyphOut->cellHeight);
+    cairo_clip(cr);
+    cairo_set_scaled_font(cr, pCairoFont->pFont);
+
+    // A glyph with colors of it's own won't come out black when it's drawn in black. These can't be used as masks.
+    cairo_set_source_rgba(cr, 0, 0, 0, 1);
+    cairo_show_glyphs(cr, &glyph, 1);
+    cairo_surface_flush(pCairoFont->pAtlasSurface);
+
+    unsigned char* pAtlasData = cairo_image_surface_get_data(pCairoFont->pAtlasSurface);
+    int atlasStride = cairo_image_surface_get_stride(pCairoFont->pAtlasSurface);
+
+    pAtlasGlyphOut->isMask = DR_TRUE;
+    for (int y = 0; y < pAtlasGlyphOut->cellHeight; ++y) {
+        dr_uint32* pRow = (dr_uint32*)(pAtlasData + (cellY + y)*atlasStride) + cellX;
+        for (int x = 0; x < pAtlasGlyphOut->cellWidth; ++x) {
+            if ((pRow[x] & 0x00FFFFFF) != 0) {
+                pAtlasGlyphOut->isMask = DR_FALSE;
+            }
+        }
+
+        memset(pRow, 0, pAtlasGlyphOut->cellWidth*4);
+    }
+
+    cairo_surface_mark_dirty_rectangle(pCairoFont->pAtlasSurface, cellX, cellY, pAtlasGlyphOut->cellWidth, pAtlasGlyphOut->cellHeight);
+
+    // Drawing the glyph in opaque white onto nothing leaves exactly the mask Cairo composites with. For subpixel antialiased glyphs this
+    // is a separate mask for each channel, and for everything else it's the same value in every channel.
+    if (pAtlasGlyphOut->isMask) {
+        cairo_set_source_rgba(cr, 1, 1, 1, 1);
+        cairo_show_glyphs(cr, &glyph, 1);
+        cairo_surface_flush(pCairoFont->pAtlasSurface);
+    }
+
+    cairo_restore(cr);
+    return DR_TRUE;
+}
+
+// Retrieves the given glyph from the atlas, rasterizing it if it's not already there.
+static cairo_atlas_glyph* dr2d__get_atlas_glyph_cairo(cairo_font_data* pCairoFont, unsigned long glyphIndex)
+{
+    assert(pCairoFont != NULL);
+
+    cairo_atlas_glyph* pAtlasGlyph = dr2d__find_atlas_glyph_cairo(pCairoFont, glyphIndex);
+    if (pAtlasGlyph != NULL) {
+        return pAtlasGlyph;
+    }
+
+    if (pCairoFont->pAtlasSurface == NULL) {
+        if (!dr2d__resize_glyph_atlas_cairo(pCairoFont, 64)) {
+            return NULL;
+        }
+    }
+
+    if ((pCairoFont->atlasGlyphCount + 1) * 4 > pCairoFont->atlasGlyphCapacity * 3) {
+        size_t newCapacity = (pCairoFont->atlasGlyphCapacity == 0) ? 64 : pCairoFont->atlasGlyphCapacity*2;
+        cairo_atlas_glyph* pNewAtlasGlyphs = (cairo_atlas_glyph*)calloc(newCapacity, sizeof(*pNewAtlasGlyphs));
+        if (pNewAtlasGlyphs == NULL) {
+            return NULL;
+        }
+
+        for (size_t iSlot = 0; iSlot < pCairoFont->atlasGlyphCapacity; ++iSlot) {
+            if (pCairoFont->pAtlasGlyphs[iSlot].key != 0) {
+                *dr2d__find_atlas_glyph_slot_cairo(pNewAtlasGlyphs, newCapacity, pCairoFont->pAtlasGlyphs[iSlot].key - 1) = pCairoFont->pAtlasGlyphs[iSlot];
+            }
+        }
+
+        free(pCairoFont->pAtlasGlyphs);
+        pCairoFont->pAtlasGlyphs = pNewAtlasGlyphs;
+        pCairoFont->atlasGlyphCapacity = newCapacity;
+    }
+
+    cairo_atlas_glyph atlasGlyph;
+    if (!dr2d__rasterize_atlas_glyph_cairo(pCairoFont, glyphIndex, &atlasGlyph)) {
+        return NULL;
+    }
+
+    // Rasterizing may have cleared the atlas so the slot can only be found now.
+    pAtlasGlyph = dr2d__find_atlas_glyph_slot_cairo(pCairoFont->pAtlasGlyphs, pCairoFont->atlasGlyphCapacity, glyphIndex);
+    *pAtlasGlyph = atlasGlyph;
+    pCairoFont->atlasGlyphCount += 1;
+
+    return pAtlasGlyph;
+}
+
+DR_INLINE dr_uint32 dr2d__mul_un8(dr_uint32 a, dr_uint32 b)
+{
+    dr_uint32 t = a*b + 0x80;
+    return ((t >> 8) + t) >> 8;
+}
+
+// Composites a premultiplied color through a mask with the OVER operator, where each channel of the mask applies to the same channel
+// of the color. This is the same arithmetic pixman uses for Cairo's image surfaces, rounding included. A mask with the same value in
+// every channel gives the same result as an A8 mask.
+DR_INLINE dr_uint32 dr2d__composite_over_cairo(dr_uint32 src, dr_uint32 mask, dr_uint32 dst)
+{
+    if (mask == 0) {
+        return dst;
+    }
+
+    dr_uint32 srcA = src >> 24;
+
+    dr_uint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        dr_uint32 m = (mask >> shift) & 0xFF;
+        dr_uint32 c = dr2d__mul_un8((dst >> shift) & 0xFF, 255 - dr2d__mul_un8(m, srcA)) + dr2d__mul_un8((src >> shift) & 0xFF, m);
+        if (c > 255) {
+            c = 255;
+        }
+
+        result |= c << shift;
+    }
+
+    return result;
+}
+
+DR_INLINE dr_uint32 dr2d__add_saturate_cairo(dr_uint32 a, dr_uint32 b)
+{
+    dr_uint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        dr_uint32 c = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF);
+        if (c > 255) {
+            c = 255;
+        }
+
+        result |= c << shift;
+    }
+
+    return result;
+}
+
+// Draws glyphs onto the surface by blitting them from the font's atlas, doing exactly what Cairo's image compositor would have done so
+// the output is the same. Returns DR_FALSE without drawing anything if the glyphs need to be drawn by Cairo.
+static dr_bool32 dr2d__show_glyphs_from_atlas_cairo(cairo_surface_data* pCairoSurface, dr2d_font* pFont, const cairo_glyph_t* pGlyphs, int glyphCount, dr2d_color color)
+{
+    assert(pCairoSurface != NULL);
+    assert(pFont != NULL);
+    assert(pGlyphs != NULL);
+
+    cairo_font_data* pCairoFont = dr2d_get_font_extra_data(pFont);
+    if (pCairoFont == NULL) {
+        return DR_FALSE;
+    }
+
+    // Translucent colors are premultiplied differently between versions of Cairo so only opaque text is drawn from the atlas.
+    if (!pCairoSurface->ownsCairoSurface || color.a != 255 || pFont->rotation != 0) {
+        return DR_FALSE;
+    }
+
+    cairo_t* cr = pCairoSurface->pCairoContext;
+
+    cairo_matrix_t transform;
+    cairo_get_matrix(cr, &transform);
+    if (transform.xx != 1 || transform.yx != 0 || transform.xy != 0 || transform.yy != 1 || transform.x0 != floor(transform.x0) || transform.y0 != floor(transform.y0)) {
+        return DR_FALSE;
+    }
+
+    double clipLeft;
+    double clipTop;
+    double clipRight;
+    double clipBottom;
+    cairo_clip_extents(cr, &clipLeft, &clipTop, &clipRight, &clipBottom);
+    if (clipLeft != floor(clipLeft) || clipTop != floor(clipTop) || clipRight != floor(clipRight) || clipBottom != floor(clipBottom)) {
+        return DR_FALSE;
+    }
+
+    // Cairo rounds glyph positions differently between versions, so glyphs that aren't on pixel boundaries are left to Cairo.
+    for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph) {
+        if (pGlyphs[iGlyph].x != floor(pGlyphs[iGlyph].x) || pGlyphs[iGlyph].y != floor(pGlyphs[iGlyph].y)) {
+            return DR_FALSE;
+        }
+    }
+
+    // Every glyph needs to be in the atlas before anything is drawn. Adding a glyph may clear the atlas, in which case it needs to be
+    // filled again. If that happens twice the glyphs won't all fit.
+    for (int iAttempt = 0; ; ++iAttempt) {
+        unsigned int clearCount = pCairoFont->atlasClearCount;
+        for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph) {
+            cairo_atlas_glyph* pAtlasGlyph = dr2d__get_atlas_glyph_cairo(pCairoFont, pGlyphs[iGlyph].index);
+            if (pAtlasGlyph == NULL || !pAtlasGlyph->isMask) {
+                return DR_FALSE;
+            }
+        }
+
+        if (clearCount == pCairoFont->atlasClearCount) {
+            break;
+        }
+
+        if (iAttempt == 1) {
+            return DR_FALSE;
+        }
+    }
+
+
+    // Cairo composites glyphs one at a time unless the ink box of one glyph overlaps the bounds of the glyphs before it, in which case
+    // the masks are added together first and composited in one go.
+    dr_int32 boundsLeft   = INT32_MAX;
+    dr_int32 boundsTop    = INT32_MAX;
+    dr_int32 boundsRight  = INT32_MIN;
+    dr_int32 boundsBottom = INT32_MIN;
+    dr_bool32 isOverlapping = DR_FALSE;
+
+    int dstLeft   = (int)clipRight;
+    int dstTop    = (int)clipBottom;
+    int dstRight  = (int)clipLeft;
+    int dstBottom = (int)clipTop;
+
+    for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph) {
+        const cairo_atlas_glyph* pAtlasGlyph = dr2d__find_atlas_glyph_cairo(pCairoFont, pGlyphs[iGlyph].index);
+        assert(pAtlasGlyph != NULL);
+
+        dr_int32 x1 = (dr_int32)pGlyphs[iGlyph].x*256 + pAtlasGlyph->bboxLeft;
+        dr_int32 y1 = (dr_int32)pGlyphs[iGlyph].y*256 + pAtlasGlyph->bboxTop;
+        dr_int32 x2 = (dr_int32)pGlyphs[iGlyph].x*256 + pAtlasGlyph->bboxRight;
+        dr_int32 y2 = (dr_int32)pGlyphs[iGlyph].y*256 + pAtlasGlyph->bboxBottom;
+
+        if (!isOverlapping && x1 != x2 && y1 != y2) {
+            isOverlapping = x2 > boundsLeft && x1 < boundsRight && y2 > boundsTop && y1 < boundsBottom;
+        }
+
+        if (boundsLeft   > x1) boundsLeft   = x1;
+        if (boundsTop    > y1) boundsTop    = y1;
+        if (boundsRight  < x2) boundsRight  = x2;
+        if (boundsBottom < y2) boundsBottom = y2;
+
+        int cellLeft = (int)pGlyphs[iGlyph].x - pAtlasGlyph->originX;
+        int cellTop  = (int)pGlyphs[iGlyph].y - pAtlasGlyph->originY;
+        if (dstLeft   > cellLeft) dstLeft   = cellLeft;
+        if (dstTop    > cellTop)  dstTop    = cellTop;
+        if (dstRight  < cellLeft + pAtlasGlyph->cellWidth)  dstRight  = cellLeft + pAtlasGlyph->cellWidth;
+        if (dstBottom < cellTop  + pAtlasGlyph->cellHeight) dstBottom = cellTop  + pAtlasGlyph->cellHeight;
+    }
+
+    // Everything from here on is done in device space. The clip is already in device space.
+    int offsetX = (int)transform.x0;
+    int offsetY = (int)transform.y0;
+    dstLeft += offsetX; dstRight  += offsetX;
+    dstTop  += offsetY; dstBottom += offsetY;
+
+    int surfaceWidth  = cairo_image_surface_get_width(pCairoSurface->pCairoSurface);
+    int surfaceHeight = cairo_image_surface_get_height(pCairoSurface->pCairoSurface);
+    int limitLeft   = (int)clipLeft   + offsetX; if (limitLeft   < 0)             limitLeft   = 0;
+    int limitTop    = (int)clipTop    + offsetY; if (limitTop    < 0)             limitTop    = 0;
+    int limitRight  = (int)clipRight  + offsetX; if (limitRight  > surfaceWidth)  limitRight  = surfaceWidth;
+    int limitBottom = (int)clipBottom + offsetY; if (limitBottom > surfaceHeight) limitBottom = surfaceHeight;
+
+    if (dstLeft   < limitLeft)   dstLeft   = limitLeft;
+    if (dstTop    < limitTop)    dstTop    = limitTop;
+    if (dstRight  > limitRight)  dstRight  = limitRight;
+    if (dstBottom > limitBottom) dstBottom = limitBottom;
+    if (dstLeft >= dstRight || dstTop >= dstBottom) {
+        return DR_TRUE;    // Everything is clipped.
+    }
+
+    int maskWidth  = dstRight  - dstLeft;
+    int maskHeight = dstBottom - dstTop;
+    if (isOverlapping && pCairoFont->atlasMaskCapacity < (size_t)maskWidth*maskHeight) {
+        dr_uint32* pNewMask = (dr_uint32*)realloc(pCairoFont->pAtlasMask, sizeof(*pNewMask) * maskWidth*maskHeight);
+        if (pNewMask == NULL) {
+            return DR_FALSE;
+        }
+
+        pCairoFont->pAtlasMask = pNewMask;
+        pCairoFont->atlasMaskCapacity = (size_t)maskWidth*maskHeight;
+    }
+
+    if (isOverlapping) {
+        memset(pCairoFont->pAtlasMask, 0, sizeof(*pCairoFont->pAtlasMask) * maskWidth*maskHeight);
+    }
+
+
+    dr_uint32 src = 0xFF000000 | ((dr_uint32)color.r << 16) | ((dr_uint32)color.g << 8) | ((dr_uint32)color.b << 0);
+
+    cairo_surface_flush(pCairoSurface->pCairoSurface);
+    unsigned char* pDstData = cairo_image_surface_get_data(pCairoSurface->pCairoSurface);
+    int dstStride = cairo_image_surface_get_stride(pCairoSurface->pCairoSurface);
+
+    const unsigned char* pAtlasData = cairo_image_surface_get_data(pCairoFont->pAtlasSurface);
+    int atlasStride = cairo_image_surface_get_stride(pCairoFont->pAtlasSurface);
+
+    for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph) {
+        const cairo_atlas_glyph* pAtlasGlyph = dr2d__find_atlas_glyph_cairo(pCairoFont, pGlyphs[iGlyph].index);
+        assert(pAtlasGlyph != NULL);
+
+        int cellLeft = (int)pGlyphs[iGlyph].x + offsetX - pAtlasGlyph->originX;
+        int cellTop  = (int)pGlyphs[iGlyph].y + offsetY - pAtlasGlyph->originY;
+
+        int left   = (cellLeft > dstLeft) ? cellLeft : dstLeft;
+        int top    = (cellTop  > dstTop)  ? cellTop  : dstTop;
+        int right  = (cellLeft + pAtlasGlyph->cellWidth  < dstRight)  ? cellLeft + pAtlasGlyph->cellWidth  : dstRight;
+        int bottom = (cellTop  + pAtlasGlyph->cellHeight < dstBottom) ? cellTop  + pAtlasGlyph->cellHeight : dstBottom;
+
+        for (int y = top; y < bottom; ++y) {
+            const dr_uint32* pMaskRow = (const dr_uint32*)(pAtlasData + (pAtlasGlyph->cellY + y - cellTop)*atlasStride) + pAtlasGlyph->cellX - cellLeft;
+            if (isOverlapping) {
+                dr_uint32* pCombinedRow = pCairoFont->pAtlasMask + (y - dstTop)*maskWidth - dstLeft;
+                for (int x = left; x < right; ++x) {
+                    pCombinedRow[x] = dr2d__add_saturate_cairo(pCombinedRow[x], pMaskRow[x]);
+                }
+            } else {
+                dr_uint32* pDstRow = (dr_uint32*)(pDstData + y*dstStride);
+                for (int x = left; x < right; ++x) {
+                    pDstRow[x] = dr2d__composite_over_cairo(src, pMaskRow[x], pDstRow[x]);
+                }
+            }
+        }
+    }
+
+    if (isOverlapping) {
+        for (int y = dstTop; y < dstBottom; ++y) {
+            const dr_uint32* pCombinedRow = pCairoFont->pAtlasMask + (y - dstTop)*maskWidth - dstLeft;
+            dr_uint32* pDstRow = (dr_uint32*)(pDstData + y*dstStride);
+            for (int x = dstLeft; x < dstRight; ++x) {
+                pDstRow[x] = dr2d__composite_over_cairo(src, pCombinedRow[x], pDstRow[x]);
+            }
+        }
+    }
+
+    cairo_surface_mark_dirty_rectangle(pCairoSurface->pCairoSurface, dstLeft, dstTop, maskWidth, maskHeight);
+    return DR_TRUE;
+}
+#endif
+
+static void dr2d__show_glyphs_cairo(cairo_surface_data* pCairoSurface, dr2d_font* pFont, const cairo_glyph_t* pGlyphs, int glyphCount, dr2d_color color)
+{
+    assert(pCairoSurface != NULL);
+
+#ifdef DR2D_CAIRO_GLYPH_ATLAS
+    if (dr2d__show_glyphs_from_atlas_cairo(pCairoSurface, pFont, pGlyphs, glyphCount, color)) {
+        return;
+    }
+#else
+    (void)pFont;
+    (void)color;
+#endif
+
+    cairo_show_glyphs(pCairoSurface->pCairoContext, pGlyphs, glyphCount);
+}
+
 dr_bool32 dr2d_get_glyph_metrics_cairo(dr2d_font* pFont, unsigned int utf32, dr2d_glyph_metrics* pGlyphMetrics)
 {
     cairo_font_data* pCairoFont = dr2d_get_font_extra_data(pFont);
@@ -3305,37 +4136,29 @@ dr_bool32 dr2d_measure_string_cairo(dr2d_font* pFont, const char* text, size_t t
         return DR_FALSE;
     }
 
-
-    // Cairo expends null terminated strings, however the input string is not guaranteed to be null terminated.
-    char* textNT;
-    if (textSizeInBytes != (size_t)-1) {
-        textNT = malloc(textSizeInBytes + 1);
-        if (textNT == NULL) {
-            return DR_FALSE;
-        }
-        memcpy(textNT, text, textSizeInBytes);
-        textNT[textSizeInBytes] = '\0';
-    } else {
-        textNT = (char*)text;
+    if (textSizeInBytes == (size_t)-1) {
+        textSizeInBytes = strlen(text);
     }
 
+    // The Cairo toy API lays out text by placing each glyph at the advance of the one before it, so the width of the string is
+    // just the sum of the advances.
+    float textWidth = 0;
+    for (size_t iByte = 0; iByte < textSizeInBytes; /* Do Nothing */) {
+        size_t byteCount;
+        unsigned int utf32 = dr2d__utf8_decode(text + iByte, textSizeInBytes - iByte, &byteCount);
 
-    cairo_text_extents_t textMetrics;
-    cairo_scaled_font_text_extents(pCairoFont->pFont, textNT, &textMetrics);
+        textWidth += dr2d__get_glyph_cairo(pCairoFont, utf32)->advanceX;
+        iByte += byteCount;
+    }
 
     if (pWidthOut) {
-        *pWidthOut = textMetrics.x_advance;
+        *pWidthOut = textWidth;
     }
     if (pHeightOut) {
         //*pHeightOut = textMetrics.height;
         *pHeightOut = pCairoFont->metrics.ascent + pCairoFont->metrics.descent;
     }
 
-
-    if (textNT != text) {
-        free(textNT);
-    }
-
     return DR_TRUE;
 }
 
@@ -3346,25 +4169,24 @@ dr_bool32 dr2d_get_text_cursor_position_from_point_cairo(dr2d_font* pFont, const
         return DR_FALSE;
     }
 
-    cairo_glyph_t* pGlyphs = NULL;
-    int glyphCount = 0;
-    cairo_status_t result = cairo_scaled_font_text_to_glyphs(pCairoFont->pFont, 0, 0, text, textSizeInBytes, &pGlyphs, &glyphCount, NULL, NULL, NULL);
-    if (result != CAIRO_STATUS_SUCCESS) {
-        return DR_FALSE;
+    if (textSizeInBytes == (size_t)-1) {
+        textSizeInBytes = strlen(text);
     }
 
     float cursorPosX = 0;
-    int charIndex = 0;
+    size_t charIndex = 0;
 
-    // We just iterate over each glyph until we find the one sitting under <inputPosX>.
+    // We just iterate over each glyph until we find the one sitting under <inputPosX>. There is one glyph for each code point.
     float runningPosX = 0;
-    for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph)
+    size_t iGlyph = 0;
+    for (size_t iByte = 0; iByte < textSizeInBytes; ++iGlyph)
     {
-        cairo_text_extents_t glyphMetrics;
-        cairo_scaled_font_glyph_extents(pCairoFont->pFont, pGlyphs + iGlyph, 1, &glyphMetrics);
+        size_t byteCount;
+        unsigned int utf32 = dr2d__utf8_decode(text + iByte, textSizeInBytes - iByte, &byteCount);
+        iByte += byteCount;
 
         float glyphLeft  = runningPosX;
-        float glyphRight = glyphLeft + glyphMetrics.x_advance;
+        float glyphRight = glyphLeft + dr2d__get_glyph_cairo(pCairoFont, utf32)->advanceX;
 
         // Are we sitting on top of inputPosX?
         if (inputPosX >= glyphLeft && inputPosX <= glyphRight)
@@ -3399,8 +4221,6 @@ dr_bool32 dr2d_get_text_cursor_position_from_point_cairo(dr2d_font* pFont, const
         }
     }
 
-    cairo_glyph_free(pGlyphs);
-
     if (pTextCursorPosXOut) {
         *pTextCursorPosXOut = cursorPosX;
     }
@@ -3418,30 +4238,21 @@ dr_bool32 dr2d_get_text_cursor_position_from_char_cairo(dr2d_font* pFont, const
         return DR_FALSE;
     }
 
-    cairo_glyph_t* pGlyphs = NULL;
-    int glyphCount = 0;
-    cairo_status_t result = cairo_scaled_font_text_to_glyphs(pCairoFont->pFont, 0, 0, text, -1, &pGlyphs, &glyphCount, NULL, NULL, NULL);
-    if (result != CAIRO_STATUS_SUCCESS) {
-        return DR_FALSE;
-    }
+    size_t textSizeInBytes = strlen(text);
 
     float cursorPosX = 0;
 
     // We just iterate over each glyph until we find the one sitting under <inputPosX>.
-    for (int iGlyph = 0; iGlyph < glyphCount; ++iGlyph)
+    size_t iByte = 0;
+    for (size_t iGlyph = 0; iGlyph < characterIndex && iByte < textSizeInBytes; ++iGlyph)
     {
-        if (iGlyph == (int)characterIndex) {
-            break;
-        }
+        size_t byteCount;
+        unsigned int utf32 = dr2d__utf8_decode(text + iByte, textSizeInBytes - iByte, &byteCount);
+        iByte += byteCount;
 
-        cairo_text_extents_t glyphMetrics;
-        cairo_scaled_font_glyph_extents(pCairoFont->pFont, pGlyphs + iGlyph, 1, &glyphMetrics);
-
-        cursorPosX += glyphMetrics.x_advance;
+        cursorPosX += dr2d__get_glyph_cairo(pCairoFont, utf32)->advanceX;
     }
 
-    cairo_glyph_free(pGlyphs);
-
     if (pTextCursorPosXOut) {
         *pTextCursorPosXOut = cursorPosX;
     }